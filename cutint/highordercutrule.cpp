@@ -0,0 +1,609 @@
+#include "highordercutrule.hpp"
+
+namespace xintegration
+{
+  // values of the Bernstein polynomials of degree p at s
+  static void BernsteinBasis (int p, double s, double * b)
+  {
+    double binom = 1;
+    for (int j = 0; j <= p; j++)
+    {
+      b[j] = binom * pow(s,j) * pow(1-s,p-j);
+      binom = binom * (p-j) / (j+1);
+    }
+  }
+
+  BernsteinTensor :: BernsteinTensor (int ad, std::array<int,3> adeg, LocalHeap & lh)
+    : d(ad), deg(adeg)
+  {
+    for (int k = d; k < 3; k++)
+      deg[k] = 0;
+    c.AssignMemory(Size(), lh);
+    c = 0.0;
+  }
+
+  int BernsteinTensor :: Size () const
+  {
+    int size = 1;
+    for (int k = 0; k < d; k++)
+      size *= deg[k]+1;
+    return size;
+  }
+
+  int BernsteinTensor :: Stride (int k) const
+  {
+    int stride = 1;
+    for (int j = k+1; j < d; j++)
+      stride *= deg[j]+1;
+    return stride;
+  }
+
+  void BernsteinTensor :: MultiIndex (int idx, int * mi) const
+  {
+    for (int k = d-1; k >= 0; k--)
+    {
+      mi[k] = idx % (deg[k]+1);
+      idx /= deg[k]+1;
+    }
+  }
+
+  bool BernsteinTensor :: Positive () const
+  {
+    for (double v : c)
+      if (v <= 0) return false;
+    return true;
+  }
+
+  bool BernsteinTensor :: Negative () const
+  {
+    for (double v : c)
+      if (v >= 0) return false;
+    return true;
+  }
+
+  double BernsteinTensor :: Eval (const double * s) const
+  {
+    // basis values of direction k start at b + offset[k]
+    int offset[3];
+    STACK_ARRAY(double, b, deg[0]+deg[1]+deg[2]+3);
+    for (int k = 0, o = 0; k < d; o += deg[k]+1, k++)
+    {
+      offset[k] = o;
+      BernsteinBasis(deg[k], s[k], b+o);
+    }
+    double sum = 0;
+    int mi[3];
+    for (int idx = 0; idx < c.Size(); idx++)
+    {
+      MultiIndex(idx, mi);
+      double prod = c(idx);
+      for (int k = 0; k < d; k++)
+        prod *= b[offset[k] + mi[k]];
+      sum += prod;
+    }
+    return sum;
+  }
+
+  BernsteinTensor BernsteinTensor :: Derivative (int k, LocalHeap & lh) const
+  {
+    auto ndeg = deg;
+    ndeg[k] = max(deg[k]-1, 0);
+    BernsteinTensor res(d, ndeg, lh);
+    if (deg[k] == 0)
+      return res;
+    int mi[3];
+    for (int idx = 0; idx < res.c.Size(); idx++)
+    {
+      res.MultiIndex(idx, mi);
+      int old = 0;
+      for (int j = 0; j < d; j++)
+        old += mi[j] * Stride(j);
+      res.c(idx) = deg[k] * (c(old + Stride(k)) - c(old));
+    }
+    return res;
+  }
+
+  BernsteinTensor BernsteinTensor :: Face (int k, int side, LocalHeap & lh) const
+  {
+    std::array<int,3> ndeg = {{0,0,0}};
+    for (int j = 0, jj = 0; j < d; j++)
+      if (j != k)
+        ndeg[jj++] = deg[j];
+    BernsteinTensor res(d-1, ndeg, lh);
+    int mi[3];
+    for (int idx = 0; idx < res.c.Size(); idx++)
+    {
+      res.MultiIndex(idx, mi);
+      int old = side * deg[k] * Stride(k);
+      for (int j = 0, jj = 0; j < d; j++)
+        if (j != k)
+          old += mi[jj++] * Stride(j);
+      res.c(idx) = c(old);
+    }
+    return res;
+  }
+
+  void BernsteinTensor :: Split (int k, BernsteinTensor & left, BernsteinTensor & right,
+                                 LocalHeap & lh) const
+  {
+    left = BernsteinTensor(d, deg, lh);
+    right = BernsteinTensor(d, deg, lh);
+    const int n = deg[k]+1;
+    const int sk = Stride(k);
+    STACK_ARRAY(double, tmp, n);
+    int mi[3];
+    for (int idx = 0; idx < c.Size(); idx++)
+    {
+      MultiIndex(idx, mi);
+      if (mi[k] != 0) continue;
+      for (int i = 0; i < n; i++)
+        tmp[i] = c(idx + i*sk);
+      for (int r = 0; r < n; r++)
+      {
+        left.c(idx + r*sk) = tmp[0];
+        right.c(idx + (n-1-r)*sk) = tmp[n-1-r];
+        for (int i = 0; i < n-1-r; i++)
+          tmp[i] = 0.5 * (tmp[i] + tmp[i+1]);
+      }
+    }
+  }
+
+  void BernsteinTensor :: Fiber (int k, const double * sbase, FlatVector<> res) const
+  {
+    int offset[3];
+    STACK_ARRAY(double, b, deg[0]+deg[1]+deg[2]+3);
+    for (int j = 0, jj = 0, o = 0; j < d; o += deg[j]+1, j++)
+    {
+      offset[j] = o;
+      if (j != k)
+        BernsteinBasis(deg[j], sbase[jj++], b+o);
+    }
+    res = 0.0;
+    int mi[3];
+    for (int idx = 0; idx < c.Size(); idx++)
+    {
+      MultiIndex(idx, mi);
+      double prod = c(idx);
+      for (int j = 0; j < d; j++)
+        if (j != k)
+          prod *= b[offset[j] + mi[j]];
+      res(mi[k]) += prod;
+    }
+  }
+
+
+  namespace
+  {
+    /// polynomial with the sign it is required to have (0: it only splits the domain)
+    struct SignedPoly
+    {
+      BernsteinTensor p;
+      int sign;
+    };
+
+    /// maximum number of subdivisions of a box before a height direction is
+    /// used even if not all functions are monotone in it
+    constexpr int SAYE_MAX_DEPTH = 6;
+
+    template <typename FUNC>
+    void TensorGauss (int d, const double * lo, const double * hi, const IntegrationRule & ir1d,
+                      const FUNC & emit)
+    {
+      const int n = ir1d.Size();
+      int total = 1;
+      for (int k = 0; k < d; k++)
+        total *= n;
+      double x[3];
+      for (int idx = 0; idx < total; idx++)
+      {
+        int rem = idx;
+        double w = 1;
+        for (int k = d-1; k >= 0; k--)
+        {
+          const int i = rem % n;
+          rem /= n;
+          x[k] = lo[k] + ir1d[i](0) * (hi[k]-lo[k]);
+          w *= ir1d[i].Weight() * (hi[k]-lo[k]);
+        }
+        emit(x, w);
+      }
+    }
+
+    /// copies the functions without a fixed sign in the box to active (of size funcs.Size())
+    /// and returns their number, -1 if the box does not contribute at all
+    int ActiveFunctions (FlatArray<SignedPoly> funcs, bool surface, FlatArray<SignedPoly> active)
+    {
+      int nactive = 0;
+      for (auto & f : funcs)
+      {
+        const bool pos = f.p.Positive();
+        if (pos || f.p.Negative())
+        {
+          if (f.sign != 0 && f.sign != (pos ? 1 : -1))
+            return -1;
+          if (surface)
+            return -1;
+          continue;
+        }
+        active[nactive++] = f;
+      }
+      return nactive;
+    }
+
+    /// calls func(a,b) for the subintervals of [0,1] between the roots of the univariate
+    /// fibers on which all fibers have their required sign
+    template <typename FUNC>
+    void FiberIntervals (FlatArray<SignedPoly> fibers, LocalHeap & lh, const FUNC & func)
+    {
+      ArrayMem<double,32> pts;
+      pts.Append(0.0);
+      pts.Append(1.0);
+      for (auto & f : fibers)
+        IsolateBernsteinRoots(f.p.c, 0, 1, pts, lh);
+      QuickSort(pts);
+      for (int i = 0; i+1 < pts.Size(); i++)
+      {
+        const double a = pts[i], b = pts[i+1];
+        if (b - a < 1e-14) continue;
+        const double mid = 0.5*(a+b);
+        bool valid = true;
+        for (auto & f : fibers)
+          if (f.sign != 0 && f.sign * EvalBernstein(f.p.c, mid) <= 0)
+            valid = false;
+        if (valid)
+          func(a, b);
+      }
+    }
+
+    /// the recursion over the dimension D of the box, all functions have f.p.d == D
+    template <int D>
+    struct SayeRecursion
+    {
+      template <typename FUNC>
+      static void Do (FlatArray<SignedPoly> funcs, const double * lo, const double * hi,
+                      bool surface, const IntegrationRule & ir1d, int depth, LocalHeap & lh,
+                      const FUNC & emit)
+      {
+        HeapReset hr(lh);
+        // remove functions with a fixed sign in the box
+        FlatArray<SignedPoly> all_active(funcs.Size(), lh);
+        const int nactive = ActiveFunctions(funcs, surface, all_active);
+        if (nactive < 0)
+          return;
+        if (nactive == 0)
+        {
+          TensorGauss(D, lo, hi, ir1d, emit);
+          return;
+        }
+        FlatArray<SignedPoly> active = all_active.Range(0, nactive);
+
+        // height direction: largest partial derivative of the first function in the center
+        const double center[3] = {0.5, 0.5, 0.5};
+        int k = 0;
+        double best = -1;
+        for (int j = 0; j < D; j++)
+        {
+          HeapReset hr(lh);
+          const double g = abs(active[0].p.Derivative(j, lh).Eval(center)) / (hi[j] - lo[j]);
+          if (g > best)
+          {
+            best = g;
+            k = j;
+          }
+        }
+        bool monotone = true;
+        for (auto & f : active)
+        {
+          HeapReset hr(lh);
+          auto df = f.p.Derivative(k, lh);
+          if (!df.Positive() && !df.Negative())
+            monotone = false;
+        }
+
+        if (!monotone && depth < SAYE_MAX_DEPTH)
+        {
+          // subdivide the box in the direction of its largest extension
+          int j = 0;
+          for (int l = 1; l < D; l++)
+            if (hi[l] - lo[l] > hi[j] - lo[j])
+              j = l;
+          FlatArray<SignedPoly> left(nactive, lh), right(nactive, lh);
+          for (int l = 0; l < nactive; l++)
+          {
+            active[l].p.Split(j, left[l].p, right[l].p, lh);
+            left[l].sign = right[l].sign = active[l].sign;
+          }
+          double lo2[3], hi2[3];
+          for (int l = 0; l < D; l++)
+          {
+            lo2[l] = lo[l];
+            hi2[l] = hi[l];
+          }
+          hi2[j] = 0.5 * (lo[j] + hi[j]);
+          Do(left, lo2, hi2, surface, ir1d, depth+1, lh, emit);
+          lo2[j] = hi2[j];
+          hi2[j] = hi[j];
+          Do(right, lo2, hi2, surface, ir1d, depth+1, lh, emit);
+          return;
+        }
+
+        // the restrictions to the lower and upper face split the base box into
+        // parts where the fibers have a fixed topology
+        FlatArray<SignedPoly> base(2*nactive, lh);
+        for (int l = 0; l < nactive; l++)
+        {
+          base[2*l] = SignedPoly{active[l].p.Face(k,0,lh), 0};
+          base[2*l+1] = SignedPoly{active[l].p.Face(k,1,lh), 0};
+        }
+        double blo[3], bhi[3];
+        for (int j = 0, jj = 0; j < D; j++)
+          if (j != k)
+          {
+            blo[jj] = lo[j];
+            bhi[jj++] = hi[j];
+          }
+        BernsteinTensor dphi_k;
+        if (surface)
+          dphi_k = active[0].p.Derivative(k, lh);
+
+        SayeRecursion<D-1>::Do(base, blo, bhi, false, ir1d, 0, lh, [&] (const double * xb, double wb)
+        {
+          HeapReset hr(lh);
+          double s[3], x[3];
+          double sb[3];
+          for (int j = 0, jj = 0; j < D; j++)
+            if (j != k)
+            {
+              x[j] = xb[jj];
+              s[j] = (xb[jj] - lo[j]) / (hi[j] - lo[j]);
+              sb[jj++] = s[j];
+            }
+
+          FlatArray<SignedPoly> fibers(nactive, lh);
+          for (int l = 0; l < nactive; l++)
+          {
+            fibers[l] = SignedPoly{BernsteinTensor(1, {{active[l].p.deg[k],0,0}}, lh), active[l].sign};
+            active[l].p.Fiber(k, sb, fibers[l].p.c);
+          }
+
+          if (surface)
+          {
+            ArrayMem<double,16> roots;
+            IsolateBernsteinRoots(fibers[0].p.c, 0, 1, roots, lh);
+            for (double r : roots)
+            {
+              s[k] = r;
+              x[k] = lo[k] + r * (hi[k] - lo[k]);
+              const double dk = abs(dphi_k.Eval(s)) / (hi[k] - lo[k]);
+              if (dk > 0)
+                emit(x, wb / dk);
+            }
+          }
+          else
+            FiberIntervals(fibers, lh, [&] (double a, double b)
+            {
+              for (auto & ip : ir1d)
+              {
+                x[k] = lo[k] + (a + ip(0) * (b - a)) * (hi[k] - lo[k]);
+                emit(x, wb * ip.Weight() * (b - a) * (hi[k] - lo[k]));
+              }
+            });
+        });
+      }
+    };
+
+    template <>
+    struct SayeRecursion<1>
+    {
+      template <typename FUNC>
+      static void Do (FlatArray<SignedPoly> funcs, const double * lo, const double * hi,
+                      bool surface, const IntegrationRule & ir1d, int depth, LocalHeap & lh,
+                      const FUNC & emit)
+      {
+        HeapReset hr(lh);
+        FlatArray<SignedPoly> all_active(funcs.Size(), lh);
+        const int nactive = ActiveFunctions(funcs, surface, all_active);
+        if (nactive < 0)
+          return;
+        if (nactive == 0)
+        {
+          TensorGauss(1, lo, hi, ir1d, emit);
+          return;
+        }
+        FiberIntervals(all_active.Range(0, nactive), lh, [&] (double a, double b)
+        {
+          for (auto & ip : ir1d)
+          {
+            const double len = (b - a) * (hi[0] - lo[0]);
+            const double x = lo[0] + (a + ip(0) * (b - a)) * (hi[0] - lo[0]);
+            emit(&x, ip.Weight() * len);
+          }
+        });
+      }
+    };
+
+    /// Quadrature on {phi < 0}, {phi > 0} or {phi = 0} of a tensor product polynomial phi on
+    /// the unit box [0,1]^D following R. Saye, "High-order quadrature methods for implicitly
+    /// defined surfaces and volumes in hyperrectangles" (SIAM J. Sci. Comput., 2015): the box
+    /// is reduced dimension by dimension along height directions in which phi is monotone
+    /// (subdividing the box otherwise), the remaining 1D problems are solved by Bernstein root
+    /// isolation. For volume rules emit(s, w) gets points s in [0,1]^D with weights w. For
+    /// dt == IF the weight is w / |d phi / d s_k| (k the height direction), i.e. the surface
+    /// weight w.r.t. the box coordinates is w * |grad phi|.
+    template <int D, typename FUNC>
+    void SayeQuadrature (const BernsteinTensor & phi, DOMAIN_TYPE dt, int order, LocalHeap & lh,
+                         const FUNC & emit)
+    {
+      HeapReset hr(lh);
+      const IntegrationRule & ir1d = SelectIntegrationRule(ET_SEGM, order);
+      FlatArray<SignedPoly> funcs(1, lh);
+      funcs[0] = SignedPoly{phi, dt == IF ? 0 : (dt == POS ? 1 : -1)};
+      const double lo[3] = {0, 0, 0};
+      const double hi[3] = {1, 1, 1};
+      SayeRecursion<D>::Do(funcs, lo, hi, dt == IF, ir1d, 0, lh, emit);
+    }
+  }
+
+
+  // maps the unit box to the reference element (Duffy transformation for simplices)
+  template <int D>
+  static void UnitBoxToElement (ELEMENT_TYPE et, const double * s, Vec<D> & x, Mat<D,D> & jac)
+  {
+    jac = 0.0;
+    if (et == ET_TRIG)
+    {
+      x(0) = s[0];
+      x(1) = s[1] * (1-s[0]);
+      jac(0,0) = 1;
+      jac(1,0) = -s[1]; jac(1,1) = 1-s[0];
+    }
+    else if (et == ET_TET)
+    {
+      x(0) = s[0];
+      x(1) = s[1] * (1-s[0]);
+      x(2) = s[2] * (1-s[0]) * (1-s[1]);
+      jac(0,0) = 1;
+      jac(1,0) = -s[1]; jac(1,1) = 1-s[0];
+      jac(2,0) = -s[2] * (1-s[1]); jac(2,1) = -s[2] * (1-s[0]); jac(2,2) = (1-s[0]) * (1-s[1]);
+    }
+    else
+    {
+      for (int j = 0; j < D; j++)
+      {
+        x(j) = s[j];
+        jac(j,j) = 1;
+      }
+    }
+  }
+
+  template <int D>
+  static const IntegrationRule * HighOrderCutIntegrationRule(const BaseScalarFiniteElement & fel,
+                                                             FlatVector<> elvec,
+                                                             const ElementTransformation & trafo,
+                                                             DOMAIN_TYPE dt,
+                                                             int intorder,
+                                                             LocalHeap & lh)
+  {
+    const ELEMENT_TYPE et = trafo.GetElementType();
+    const bool simplex = (et == ET_TRIG) || (et == ET_TET);
+    const int q = fel.Order();
+    const int n = q+1;
+
+    // Bernstein coefficients of the level set function on the unit box (from
+    // the values in the equidistant points)
+    std::array<int,3> deg = {{0,0,0}};
+    for (int j = 0; j < D; j++)
+      deg[j] = q;
+    BernsteinTensor phi(D, deg, lh);
+    {
+      HeapReset hr(lh);
+      FlatVector<> shape(fel.GetNDof(), lh);
+      int mi[3];
+      double s[3];
+      Vec<D> x;
+      Mat<D,D> jac;
+      for (int idx = 0; idx < phi.Size(); idx++)
+      {
+        phi.MultiIndex(idx, mi);
+        for (int j = 0; j < D; j++)
+          s[j] = q > 0 ? double(mi[j]) / q : 0.5;
+        UnitBoxToElement<D>(et, s, x, jac);
+        IntegrationPoint ip(x(0), x(1), D == 3 ? x(D-1) : 0.0, 0.0);
+        fel.CalcShape(ip, shape);
+        phi.c(idx) = InnerProduct(shape, elvec);
+      }
+
+      FlatMatrix<> bmat(n, n, lh);
+      for (int i = 0; i < n; i++)
+        BernsteinBasis(q, q > 0 ? double(i) / q : 0.5, &bmat(i,0));
+      CalcInverse(bmat);
+      FlatVector<> vals(n, lh), coefs(n, lh);
+      for (int j = 0; j < D; j++)
+      {
+        const int sj = phi.Stride(j);
+        for (int idx = 0; idx < phi.Size(); idx++)
+        {
+          phi.MultiIndex(idx, mi);
+          if (mi[j] != 0) continue;
+          for (int i = 0; i < n; i++)
+            vals(i) = phi.c(idx + i*sj);
+          coefs = bmat * vals;
+          for (int i = 0; i < n; i++)
+            phi.c(idx + i*sj) = coefs(i);
+        }
+      }
+    }
+
+    if (phi.Positive() || phi.Negative())
+    {
+      const DOMAIN_TYPE element_domain = phi.Positive() ? POS : NEG;
+      if (element_domain != dt)
+        return nullptr;
+      return & (SelectIntegrationRule (et, intorder));
+    }
+
+    std::array<BernsteinTensor,3> dphi;
+    if (dt == IF)
+      for (int j = 0; j < D; j++)
+        dphi[j] = phi.Derivative(j, lh);
+
+    // the Duffy transformation increases the polynomial degree of the integrand
+    const int order = simplex ? intorder + D - 1 : intorder;
+
+    IntegrationRule quad_untrafo;
+    SayeQuadrature<D>(phi, dt, order, lh, [&] (const double * s, double w)
+    {
+      Vec<D> x;
+      Mat<D,D> jac;
+      UnitBoxToElement<D>(et, s, x, jac);
+      const double det = Det(jac);
+      if (det <= 0)
+        return;
+      if (dt == IF)
+      {
+        // surface weight w.r.t. the reference element: w * |grad_x phi| * det, transformed
+        // s.t. the scaling with mip.GetMeasure() gives the physical surface measure
+        Vec<D> grad_s;
+        for (int j = 0; j < D; j++)
+          grad_s(j) = dphi[j].Eval(s);
+        Mat<D,D> jacinv = Inv(jac);
+        Vec<D> grad_x = Trans(jacinv) * grad_s;
+        IntegrationPoint ip(x(0), x(1), D == 3 ? x(D-1) : 0.0, 0.0);
+        MappedIntegrationPoint<D,D> mip(ip, trafo);
+        Vec<D> normal = Trans(mip.GetJacobianInverse()) * grad_x;
+        w *= det * L2Norm(normal);
+      }
+      else
+        w *= det;
+      quad_untrafo.Append(IntegrationPoint(x(0), x(1), D == 3 ? x(D-1) : 0.0, w));
+    });
+
+    if (quad_untrafo.Size() == 0)
+      return nullptr;
+    auto ir = new (lh) IntegrationRule(quad_untrafo.Size(), lh);
+    for (int i = 0; i < ir->Size(); i++)
+      (*ir)[i] = quad_untrafo[i];
+    return ir;
+  }
+
+  const IntegrationRule * HighOrderCutIntegrationRule(const FiniteElement & fel,
+                                                      FlatVector<> elvec,
+                                                      const ElementTransformation & trafo,
+                                                      DOMAIN_TYPE dt,
+                                                      int intorder,
+                                                      LocalHeap & lh)
+  {
+    static Timer t ("HighOrderCutIntegrationRule");
+    RegionTimer reg(t);
+
+    const ELEMENT_TYPE et = trafo.GetElementType();
+    if ((et != ET_TRIG) && (et != ET_TET) && (et != ET_QUAD) && (et != ET_HEX))
+      throw Exception("HighOrderCutIntegrationRule: only trigs, tets, quads and hexes");
+
+    const BaseScalarFiniteElement & scafe = dynamic_cast<const BaseScalarFiniteElement &>(fel);
+    if (trafo.SpaceDim() == 2)
+      return HighOrderCutIntegrationRule<2>(scafe, elvec, trafo, dt, intorder, lh);
+    else
+      return HighOrderCutIntegrationRule<3>(scafe, elvec, trafo, dt, intorder, lh);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "xintegration.hpp"
+#include <array>
+
+using namespace ngfem;
+
+namespace xintegration
+{
+  /// roots in (0,1) of the Bernstein polynomial with coefficients c, mapped to [a,b]
+  void IsolateBernsteinRoots (FlatVector<> c, double a, double b, Array<double> & roots,
+                              LocalHeap & lh, int depth = 0);
+
+  /// de Casteljau evaluation of a Bernstein polynomial on [0,1]
+  double EvalBernstein (FlatVector<> c, double s);
+
+  /// Tensor product polynomial in Bernstein form on [0,1]^d (d <= 3) with degree deg[k] in
+  /// direction k. The coefficient of the multi-index (i_0,..,i_{d-1}) is stored at
+  /// sum_k i_k * Stride(k) (last direction fastest). The coefficients live on a LocalHeap,
+  /// copies only copy the view.
+  class BernsteinTensor
+  {
+  public:
+    int d = 0;
+    std::array<int,3> deg = {{0,0,0}};
+    FlatVector<> c;
+
+    BernsteinTensor () : c(0, (double*)nullptr) { ; }
+    BernsteinTensor (int ad, std::array<int,3> adeg, LocalHeap & lh);
+    BernsteinTensor (const BernsteinTensor & other) = default;
+    BernsteinTensor & operator= (const BernsteinTensor & other)
+    {
+      d = other.d;
+      deg = other.deg;
+      c.AssignMemory(other.c.Size(), other.c.Addr(0));
+      return *this;
+    }
+
+    int Size () const;
+    int Stride (int k) const;
+    void MultiIndex (int idx, int * mi) const;
+
+    /// all coefficients strictly positive / negative (=> the polynomial has this sign)
+    bool Positive () const;
+    bool Negative () const;
+
+    double Eval (const double * s) const;
+    /// partial derivative in direction k (w.r.t. the unit box)
+    BernsteinTensor Derivative (int k, LocalHeap & lh) const;
+    /// restriction to the face s_k = side (0 or 1), a tensor in d-1 dimensions
+    BernsteinTensor Face (int k, int side, LocalHeap & lh) const;
+    /// de Casteljau subdivision at s_k = 1/2, both halves w.r.t. their own unit box
+    void Split (int k, BernsteinTensor & left, BernsteinTensor & right, LocalHeap & lh) const;
+    /// univariate Bernstein coefficients in direction k at the point sbase of the other
+    /// directions (res has size deg[k]+1)
+    void Fiber (int k, const double * sbase, FlatVector<> res) const;
+  };
+
+  /// Cut integration rule for a higher order (scalar) level set function given by fel and its
+  /// coefficients elvec on trigs, quads, tets and hexes. Simplices are mapped to the unit box by a
+  /// Duffy transformation. The weights follow the convention of StraightCutIntegrationRule.
+  const IntegrationRule * HighOrderCutIntegrationRule(const FiniteElement & fel,
+                                                      FlatVector<> elvec,
+                                                      const ElementTransformation & trafo,
+                                                      DOMAIN_TYPE dt,
+                                                      int intorder,
+                                                      LocalHeap & lh);
+}
@@ -26,6 +26,7 @@ void ExportNgsx_cutint(py::module &m)
            int subdivlvl,
            int time_order,
            SWAP_DIMENSIONS_POLICY quad_dir_policy,
+           bool highorder_lset,
            int heapsize)
         {
           py::extract<PyCF> pycf(lset);
@@ -34,7 +35,7 @@ void ExportNgsx_cutint(py::module &m)
 
           shared_ptr<GridFunction> gf_lset = nullptr;
           shared_ptr<CoefficientFunction> cf_lset = nullptr;
-          tie(cf_lset,gf_lset) = CF2GFForStraightCutRule(pycf(),subdivlvl);
+          tie(cf_lset,gf_lset) = CF2GFForStraightCutRule(pycf(),subdivlvl,highorder_lset);
 
           LocalHeap lh(heapsize, "lh-IntegrateX");
 
@@ -74,6 +75,7 @@ void ExportNgsx_cutint(py::module &m)
         py::arg("subdivlvl")=0,
         py::arg("time_order")=-1,
         py::arg("quad_dir_policy")=FIND_OPTIMAL,
+        py::arg("highorder_lset")=false,
         py::arg("heapsize")=1000000,
         docu_string(R"raw_string(
 Integrate on a level set domains. The accuracy of the integration is 'order' w.r.t. a (multi-)linear
@@ -115,6 +117,11 @@ heapsize : int
 
 quad_dir_policy : int
   policy for the selection of the order of integration directions
+
+highorder_lset : boolean
+  If lset is a higher order H1 GridFunction, construct the cut rule directly on its
+  (higher order) zero level (only volume elements: trigs, quads, tets, hexes). Otherwise
+  (default) the level set is evaluated on the vertices only.
 )raw_string"));
 
 }
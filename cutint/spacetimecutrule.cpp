@@ -1,9 +1,140 @@
 #include "spacetimecutrule.hpp"
+#include "highordercutrule.hpp"
 #include "../spacetime/SpaceTimeFE.hpp"
 
 namespace xintegration
 {
-    vector<double> root_finding(SliceVector<> li, ScalarFiniteElement<1>* fe_time, LocalHeap& lh, int subdivs=50, int bisection_iterations = 70){
+    // Root isolation for polynomials of arbitrary order in time: the time
+    // polynomials of all vertices are transformed to Bernstein form at once,
+    // afterwards the sign changes of the Bernstein coefficients (variation
+    // diminishing property) are used to isolate the roots by de Casteljau
+    // subdivision. Isolated roots are refined with the Illinois method.
+
+    // matrix that maps coefficients w.r.t. fe_time to Bernstein coefficients,
+    // NodalTimeFE sets it up once per element (not per spatial element)
+    static FlatMatrix<> GetBernsteinTrafo (ScalarFiniteElement<1>* fe_time, LocalHeap & lh)
+    {
+      if (auto nodal_fe = dynamic_cast<NodalTimeFE*>(fe_time))
+        return nodal_fe->GetBernsteinTrafo();
+      FlatMatrix<> trafo(fe_time->Order()+1, fe_time->GetNDof(), lh);
+      CalcBernsteinTrafo(*fe_time, trafo);
+      return trafo;
+    }
+
+    static int BernsteinSignChanges (FlatVector<> c)
+    {
+      int changes = 0;
+      double last = 0;
+      for (double v : c)
+      {
+        if (v == 0) continue;
+        if (last * v < 0) changes++;
+        last = v;
+      }
+      return changes;
+    }
+
+    // de Casteljau evaluation of a Bernstein polynomial on [0,1]
+    double EvalBernstein (FlatVector<> c, double s)
+    {
+      STACK_ARRAY(double, tmp, c.Size());
+      for (int i = 0; i < c.Size(); i++) tmp[i] = c(i);
+      for (int r = 1; r < c.Size(); r++)
+        for (int i = 0; i < c.Size()-r; i++)
+          tmp[i] = (1-s) * tmp[i] + s * tmp[i+1];
+      return tmp[0];
+    }
+
+    // c has exactly one root in (0,1) with c(0)*c(1) < 0, returns it mapped to [a,b]
+    static double RefineBernsteinRoot (FlatVector<> c, double a, double b, int maxit = 100)
+    {
+      double s0 = 0, s1 = 1;
+      double f0 = c(0), f1 = c(c.Size()-1);
+      int side = 0;
+      double s = 0.5;
+      for (int it = 0; it < maxit; it++)
+      {
+        s = (s0*f1 - s1*f0) / (f1 - f0);
+        const double f = EvalBernstein(c, s);
+        if (2*abs(f) < 1e-12 || s1 - s0 < 1e-14)
+          break;
+        if (f * f1 > 0)
+        {
+          s1 = s; f1 = f;
+          if (side == -1) f0 *= 0.5;
+          side = -1;
+        }
+        else
+        {
+          s0 = s; f0 = f;
+          if (side == 1) f1 *= 0.5;
+          side = 1;
+        }
+      }
+      return a + s * (b-a);
+    }
+
+    void IsolateBernsteinRoots (FlatVector<> c, double a, double b, Array<double> & roots,
+                                LocalHeap & lh, int depth)
+    {
+      const int n = c.Size();
+      const int changes = BernsteinSignChanges(c);
+      if (changes == 0)
+        return;
+      if (changes == 1 && c(0) * c(n-1) < 0)
+      {
+        roots.Append(RefineBernsteinRoot(c, a, b));
+        return;
+      }
+      if (depth > 50 || b - a < 1e-12)
+      {
+        roots.Append(0.5*(a+b));
+        return;
+      }
+
+      HeapReset hr(lh);
+      FlatVector<> left(n, lh), right(n, lh);
+      FlatVector<> tmp(n, lh);
+      tmp = c;
+      for (int r = 0; r < n; r++)
+      {
+        left(r) = tmp(0);
+        right(n-1-r) = tmp(n-1-r);
+        for (int i = 0; i < n-1-r; i++)
+          tmp(i) = 0.5 * (tmp(i) + tmp(i+1));
+      }
+      const double m = 0.5*(a+b);
+      if (left(n-1) == 0)
+        roots.Append(m);
+      IsolateBernsteinRoots(left, a, m, roots, lh, depth+1);
+      IsolateBernsteinRoots(right, m, b, roots, lh, depth+1);
+    }
+
+    // roots in (0,1) of the time polynomials of all columns of lset_st
+    void BernsteinRootFinding (FlatMatrix<> lset_st, ScalarFiniteElement<1>* fe_time,
+                               vector<double> & roots, LocalHeap & lh)
+    {
+      static Timer t ("SpaceTimeCutIntegrationRule::BernsteinRootFinding");
+      RegionTimer reg(t);
+      HeapReset hr(lh);
+      const int n = fe_time->Order()+1;
+      if (n < 2) return;
+      FlatMatrix<> trafo = GetBernsteinTrafo(fe_time, lh);
+      FlatMatrix<> bcoefs(n, lset_st.Width(), lh);
+      bcoefs = trafo * lset_st;
+      FlatVector<> c(n, lh);
+      ArrayMem<double,16> croots;
+      for (int i = 0; i < lset_st.Width(); i++)
+      {
+        c = bcoefs.Col(i);
+        croots.SetSize0();
+        IsolateBernsteinRoots(c, 0, 1, croots, lh);
+        for (double r : croots)
+          roots.push_back(r);
+      }
+    }
+
+    vector<double> root_finding(SliceVector<> li, ScalarFiniteElement<1>* fe_time, LocalHeap& lh){
         // if(li.Size() == 2){
        if(fe_time->Order() == 0)
          return {};
@@ -40,57 +171,225 @@ namespace xintegration
            return roots;
        }
         else {
-            static bool first = true;
-            if (first)
-            {
-              cout << "Calling bisection for root finding ..." << endl;
-              first = false;
-            }
-            vector<double> vals(subdivs); vector<tuple<double,double>> sign_change_intervals;
-            vector<double> roots; double delta_x = 1./subdivs;
-            FlatVector<> shape(li.Size(), lh);
-            function<double(double)> eval = [&li, &fe_time, &shape](double xi) -> double {
-                fe_time->CalcShape(IntegrationPoint(Vec<3>{xi,0,0}, 0.), shape);
-                return InnerProduct(li,shape);
-            };
-            for(int i=0; i<subdivs+1; i++){
-                double xi = delta_x*i;
-                vals[i] = eval(xi);
-                if(vals[i] == 0)
-                  roots.push_back(xi);
-                if(i >= 1) if(vals[i-1] * vals[i] < 0) sign_change_intervals.push_back(make_tuple( xi-delta_x, xi));
-            }
-            for(auto interval : sign_change_intervals){
-                double a = get<0>(interval), b = get<1>(interval); double x_mid;
-                double aval = eval(a), bval = eval(b);
-                for(int j=0; j<bisection_iterations; j++){
-                  
-                  //secant rule stopping criteria
-                  const double x_lin = a - aval*(b-a)/(bval-aval);
-                  double val = eval(x_lin);
-                  if (2*abs(val) < 1e-12)
-                  {
-                    a=b=x_lin;
-                    break;
-                  }
-
-                  x_mid = 0.5*(a+b);
-                  val = eval(x_mid);
-                    if(val == 0) break;
-                    if(val * aval < 0) {
-                        b = x_mid; bval = val;
-                    }
-                    else if(val * bval < 0){
-                        a = x_mid; aval = val;
-                    }
-                    else throw Exception("Strange sign structure during bisection!");
-                }
-                roots.push_back(0.5*(a+b));
-            }
+            vector<double> roots;
+            HeapReset hr(lh);
+            FlatMatrix<> lmat(li.Size(), 1, lh);
+            lmat.Col(0) = li;
+            BernsteinRootFinding(lmat, fe_time, roots, lh);
             return roots;
         }
     }
 
+    // Topology of the decomposition of a cut simplex (segment or triangle).
+    // It only depends on the sign pattern of the level set values on the
+    // vertices, s.t. it can be reused for all time points with the same
+    // pattern. Vertex indices < nv refer to the vertices of the element,
+    // nv + k refers to the k-th cut edge. Same decomposition as in
+    // LevelsetCutSimplex::Decompose.
+    struct SimplexCutPattern
+    {
+      int nv;
+      int ncut = 0;
+      int cut_edges[3][2];
+      int dim_sub = 0;
+      int nsub = 0;
+      int sub_verts[2][3];
+      int npoints = 0;
+    };
+
+    static bool BuildSimplexCutPattern (ELEMENT_TYPE et, unsigned signs, DOMAIN_TYPE dt,
+                                        int order, SimplexCutPattern & pat)
+    {
+      const int D = (et == ET_SEGM) ? 1 : 2;
+      pat.nv = D+1;
+      pat.ncut = 0;
+      for (int i = 0; i < pat.nv; i++)
+        for (int j = i+1; j < pat.nv; j++)
+          if (((signs >> i) & 1) != ((signs >> j) & 1))
+          {
+            pat.cut_edges[pat.ncut][0] = i;
+            pat.cut_edges[pat.ncut][1] = j;
+            pat.ncut++;
+          }
+      if (pat.ncut != D)
+        return false;
+
+      const int c0 = pat.nv, c1 = pat.nv + 1;
+      if (dt == IF)
+      {
+        pat.dim_sub = D-1;
+        pat.nsub = 1;
+        pat.sub_verts[0][0] = c0;
+        if (D == 2) pat.sub_verts[0][1] = c1;
+      }
+      else
+      {
+        int relevant[3]; int nrel = 0;
+        for (int i = 0; i < pat.nv; i++)
+          if (((dt == POS) && ((signs >> i) & 1)) || ((dt == NEG) && !((signs >> i) & 1)))
+            relevant[nrel++] = i;
+        pat.dim_sub = D;
+        if (nrel == 1)
+        {
+          pat.nsub = 1;
+          pat.sub_verts[0][0] = c0;
+          if (D == 2) pat.sub_verts[0][1] = c1;
+          pat.sub_verts[0][D] = relevant[0];
+        }
+        else if ((nrel == 2) && (D == 2))
+        {
+          pat.nsub = 2;
+          pat.sub_verts[0][0] = relevant[0];
+          pat.sub_verts[0][1] = relevant[1];
+          pat.sub_verts[0][2] = c1;
+          pat.sub_verts[1][0] = c0;
+          pat.sub_verts[1][1] = c1;
+          pat.sub_verts[1][2] = relevant[0];
+        }
+        else
+          return false;
+      }
+
+      ELEMENT_TYPE et_sub = pat.dim_sub == 0 ? ET_POINT : (pat.dim_sub == 1 ? ET_SEGM : ET_TRIG);
+      pat.npoints = pat.nsub * SelectIntegrationRule(et_sub, order).Size();
+      return true;
+    }
+
+    // vertices of the reference simplices in the ordering of SimpleX(et)
+    static Vec<3> SimplexVertex (ELEMENT_TYPE et, int i)
+    {
+      if (et == ET_SEGM) return i == 0 ? Vec<3>(1,0,0) : Vec<3>(0,0,0);
+      switch (i)
+      {
+        case 0 : return Vec<3>(1,0,0);
+        case 1 : return Vec<3>(0,1,0);
+        default : return Vec<3>(0,0,0);
+      }
+    }
+
+    template <int D>
+    static void ScaleInterfaceWeights (IntegrationRule & ir, int first, int next,
+                                       const ElementTransformation & trafo, Vec<3> ref_normal)
+    {
+      Vec<D> n;
+      for (int d = 0; d < D; d++)
+        n(d) = ref_normal(d);
+      for (int k = first; k < next; k++)
+      {
+        MappedIntegrationPoint<D,D> mip(ir[k],trafo);
+        Vec<D> normal = Trans(mip.GetJacobianInverse()) * n;
+        ir[k].SetWeight(ir[k].Weight() * L2Norm(normal));
+      }
+    }
+
+    // put the (spatial) points of a cut simplex with given pattern into ir[offset,...)
+    static void FillSimplexCutRule (ELEMENT_TYPE et, const SimplexCutPattern & pat,
+                                    FlatVector<> lset, DOMAIN_TYPE dt, int order,
+                                    const ElementTransformation & trafo,
+                                    IntegrationRule & ir, int offset)
+    {
+      Vec<3> verts[5];
+      for (int i = 0; i < pat.nv; i++)
+        verts[i] = SimplexVertex(et, i);
+      for (int k = 0; k < pat.ncut; k++)
+      {
+        const int i = pat.cut_edges[k][0], j = pat.cut_edges[k][1];
+        verts[pat.nv+k] = verts[i] + (lset(i)/(lset(i)-lset(j))) * (verts[j] - verts[i]);
+      }
+
+      ELEMENT_TYPE et_sub = pat.dim_sub == 0 ? ET_POINT : (pat.dim_sub == 1 ? ET_SEGM : ET_TRIG);
+      const IntegrationRule & ir_sub = SelectIntegrationRule(et_sub, order);
+      int cnt = offset;
+      for (int l = 0; l < pat.nsub; l++)
+      {
+        const int * sv = pat.sub_verts[l];
+        double trafofac = 1.0;
+        if (pat.dim_sub == 1)
+          trafofac = L2Norm(verts[sv[1]] - verts[sv[0]]);
+        else if (pat.dim_sub == 2)
+          trafofac = L2Norm(Cross(Vec<3>(verts[sv[2]] - verts[sv[0]]), Vec<3>(verts[sv[1]] - verts[sv[0]])));
+        for (const auto & ip : ir_sub)
+        {
+          double originweight = 1.0;
+          for (int m = 0; m < pat.dim_sub; m++) originweight -= ip(m);
+          Vec<3> point = originweight * verts[sv[0]];
+          for (int m = 0; m < pat.dim_sub; m++)
+            point += ip(m) * verts[sv[m+1]];
+          ir[cnt++] = IntegrationPoint(point, ip.Weight() * trafofac);
+        }
+      }
+
+      if (dt == IF)
+      {
+        // gradient of the linear level set on the reference element (cf. LevelsetWrapper)
+        Vec<3> grad(0.0);
+        const int last = pat.nv - 1;
+        for (int d = 0; d < last; d++)
+          grad(d) = lset(d) - lset(last);
+        grad /= L2Norm(grad);
+        if (trafo.SpaceDim() == 1)
+          ScaleInterfaceWeights<1>(ir, offset, cnt, trafo, grad);
+        else
+          ScaleInterfaceWeights<2>(ir, offset, cnt, trafo, grad);
+      }
+    }
+
+    // Cheap classification of the time polynomials of all vertices before any
+    // root finding. Bernstein coefficients bound the polynomial on [0,1]
+    // (convex hull property), so strictly one-signed coefficients give an
+    // element that is not cut during the whole slab. Identical coefficients
+    // of every vertex mean a level set that does not change in time. The
+    // transformation to Bernstein form is the one of the time element (see
+    // GetBernsteinTrafo), it also covers time elements with reduced bases.
+    enum TIME_BEHAVIOUR { TIME_GENERIC, TIME_CONSTANT, TIME_POS, TIME_NEG };
+
+    static TIME_BEHAVIOUR ClassifyTimeBehaviour (FlatMatrix<> lset_st, ScalarFiniteElement<1>* fe_time,
+                                                 FlatVector<> lset_const, LocalHeap & lh)
+    {
+      HeapReset hr(lh);
+      const int n = fe_time->Order()+1;
+      FlatMatrix<> bcoefs(n, lset_st.Width(), lh);
+      bcoefs = GetBernsteinTrafo(fe_time, lh) * lset_st;
+
+      bool all_pos = true, all_neg = true;
+      double maxabs = 0;
+      for (int k = 0; k < n; k++)
+        for (int i = 0; i < bcoefs.Width(); i++)
+        {
+          const double v = bcoefs(k,i);
+          if (v <= 0) all_pos = false;
+          if (v >= 0) all_neg = false;
+          maxabs = max2(maxabs, abs(v));
+        }
+      if (all_pos) return TIME_POS;
+      if (all_neg) return TIME_NEG;
+
+      for (int k = 1; k < n; k++)
+        for (int i = 0; i < bcoefs.Width(); i++)
+          if (abs(bcoefs(k,i) - bcoefs(0,i)) > 1e-12 * maxabs)
+            return TIME_GENERIC;
+      lset_const = bcoefs.Row(0);
+      return TIME_CONSTANT;
+    }
+
+    // spatial rule x time rule, time coordinate as in SpaceTimeCutIntegrationRule
+    static const IntegrationRule * TimeTensorProductRule (const IntegrationRule & ir_space,
+                                                          const IntegrationRule & ir_time,
+                                                          int sdim, LocalHeap & lh)
+    {
+      auto ir = new (lh) IntegrationRule(ir_space.Size() * ir_time.Size(), lh);
+      int cnt = 0;
+      for (const auto & ipt : ir_time)
+        for (const auto & ips : ir_space)
+        {
+          IntegrationPoint & ip = (*ir)[cnt++];
+          ip = ips;
+          if (sdim < 3) ip.Point()[sdim] = ipt.Point()[0];
+          ip.SetWeight(ips.Weight() * ipt.Weight());
+        }
+      return ir;
+    }
+
     const IntegrationRule * SpaceTimeCutIntegrationRule(FlatVector<> cf_lset_at_element,
                                                         const ElementTransformation &trafo,
                                                         ScalarFiniteElement<1>* fe_time,
@@ -99,89 +398,179 @@ namespace xintegration
                                                         int order_space,
                                                         SWAP_DIMENSIONS_POLICY quad_dir_policy,
                                                         LocalHeap & lh){
+        static Timer t ("SpaceTimeCutIntegrationRule");
+        RegionTimer reg(t);
+
+        // the time is stored in the coordinate after the spatial ones
+        if (trafo.SpaceDim() == 3)
+          throw Exception("SpaceTimeCutIntegrationRule: no space-time cut rules on 3D meshes, 3D space-time slabs can only be evaluated at fixed times");
+
         ELEMENT_TYPE et_space = trafo.GetElementType();
         int lset_nfreedofs = cf_lset_at_element.Size();
         int space_nfreedofs = ElementTopology::GetNVertices(et_space);
         int time_nfreedofs = lset_nfreedofs / space_nfreedofs;
         FlatMatrix<> lset_st(time_nfreedofs, space_nfreedofs, &cf_lset_at_element(0,0));
 
-        vector<double> cut_points{0,1};
-        for(int i=0; i<space_nfreedofs; i++){
-            auto li = lset_st.Col(i);
-            auto cp = root_finding(li, fe_time, lh);
-            if(cp.size() > 0) cut_points.insert(cut_points.begin(), cp.begin(), cp.end());
+        const IntegrationRule & ir_time = SelectIntegrationRule(ET_SEGM, order_time);
+        const IntegrationRule & ir_plain = SelectIntegrationRule (et_space, order_space);
+        const bool is_simplex = (et_space == ET_SEGM) || (et_space == ET_TRIG);
+
+        // elements that are uncut during the whole slab or with a level set
+        // that does not depend on time need neither root finding nor spatial
+        // cut rules per time point
+        FlatVector<> lset_const(space_nfreedofs, lh);
+        const TIME_BEHAVIOUR behaviour = ClassifyTimeBehaviour(lset_st, fe_time, lset_const, lh);
+        switch (behaviour)
+        {
+          case TIME_POS:
+          case TIME_NEG:
+            if (dt != (behaviour == TIME_POS ? POS : NEG))
+              return nullptr;
+            return TimeTensorProductRule(ir_plain, ir_time, trafo.SpaceDim(), lh);
+          case TIME_CONSTANT:
+            {
+              const DOMAIN_TYPE element_domain = CheckIfStraightCut(lset_const);
+              if (element_domain == dt)
+                return TimeTensorProductRule(ir_plain, ir_time, trafo.SpaceDim(), lh);
+              if (element_domain != IF)
+                return nullptr;
+              SimplexCutPattern pat;
+              unsigned signs = 0;
+              for (int k = 0; k < space_nfreedofs; k++)
+                if (lset_const(k) >= 0) signs |= (1u << k);
+              const IntegrationRule * ir_space = nullptr;
+              if (is_simplex && BuildSimplexCutPattern(et_space, signs, dt, order_space, pat))
+              {
+                auto ir_cut = new (lh) IntegrationRule(pat.npoints, lh);
+                FillSimplexCutRule(et_space, pat, lset_const, dt, order_space, trafo, *ir_cut, 0);
+                ir_space = ir_cut;
+              }
+              else
+                ir_space = StraightCutIntegrationRule(lset_const, trafo, dt, order_space, quad_dir_policy, lh);
+              if (ir_space == nullptr || ir_space->Size() == 0)
+                return nullptr;
+              return TimeTensorProductRule(*ir_space, ir_time, trafo.SpaceDim(), lh);
+            }
+          default:
+            break;
         }
+
+        vector<double> cut_points{0,1};
+        // the closed formulas of root_finding assume a full nodal basis
+        if (fe_time->Order() > 2 || fe_time->GetNDof() != fe_time->Order()+1)
+            BernsteinRootFinding(lset_st, fe_time, cut_points, lh);
+        else
+            for(int i=0; i<space_nfreedofs; i++){
+                auto li = lset_st.Col(i);
+                auto cp = root_finding(li, fe_time, lh);
+                if(cp.size() > 0) cut_points.insert(cut_points.begin(), cp.begin(), cp.end());
+            }
         sort(cut_points.begin(), cut_points.end());
+        // roots shared by several vertices only give empty time intervals
+        cut_points.erase(unique(cut_points.begin(), cut_points.end(),
+                                [](double a, double b) { return b - a < 1e-14; }),
+                         cut_points.end());
+        cut_points.back() = 1;
 
-        const IntegrationRule & ir_time = SelectIntegrationRule(ET_SEGM, order_time);
-        auto ir = new (lh) IntegrationRule();
+        const int nt = (cut_points.size() - 1) * ir_time.Size();
+
+        // first pass: level set values, domain and number of points per time point
+        enum { NO_POINTS = -1, PLAIN_RULE = -2, STRAIGHTCUT_RULE = -3 };
+        FlatVector<> shape(time_nfreedofs, lh);
+        FlatMatrix<> lset_at_t(nt, space_nfreedofs, lh);
+        FlatArray<double> times(nt, lh);
+        FlatArray<double> tweights(nt, lh);
+        FlatArray<int> rule_type(nt, lh);
+        FlatArray<const IntegrationRule*> sub_rules(nt, lh);
+
+        // decompositions are set up once per sign pattern (at most 2^3 for a triangle)
+        SimplexCutPattern patterns[8];
+        bool pattern_built[8] = { false };
+        bool pattern_ok[8] = { false };
 
+        int total = 0;
+        int cnt = 0;
         for(int i=0; i<cut_points.size() -1; i++){
             double t0 = cut_points[i], t1 = cut_points[i+1];
             for(auto ip:ir_time){
-                double t = t0 + ip.Point()[0]*(t1 - t0);
-                FlatVector<> cf_lset_at_t(space_nfreedofs,lh);
-                FlatVector<> shape(time_nfreedofs, lh);
-                fe_time->CalcShape(IntegrationPoint(Vec<3>{t,0,0}, 0.), shape);
+                double tval = t0 + ip.Point()[0]*(t1 - t0);
+                times[cnt] = tval;
+                tweights[cnt] = ip.Weight()*(t1-t0);
+                fe_time->CalcShape(IntegrationPoint(Vec<3>{tval,0,0}, 0.), shape);
+                FlatVector<> cf_lset_at_t = lset_at_t.Row(cnt);
                 cf_lset_at_t = Trans(lset_st)*shape;
 
                 auto element_domain = CheckIfStraightCut(cf_lset_at_t);
-
-                const int offset = ir->Size();
-                if (element_domain == IF)
-                    ir->Append(*StraightCutIntegrationRule(cf_lset_at_t, trafo, dt, order_space, quad_dir_policy, lh));
-                else if (element_domain == dt)
-                    ir->Append(SelectIntegrationRule (et_space, order_space));
-
-                const int newsize = ir->Size();                    
-                for(int k = offset; k < newsize; k++) {
-                    if(trafo.SpaceDim() == 1) (*ir)[k].Point()[1] = t;
-                    if(trafo.SpaceDim() == 2) (*ir)[k].Point()[2] = t;
-                    (*ir)[k].SetWeight((*ir)[k].Weight()*ip.Weight()*(t1-t0));
-                }
-                /*                                     
-                CutSimplexElementGeometry geom(cf_lset_at_t, et_space, lh);
-                CutQuadElementGeometry geom_quad(cf_lset_at_t, et_space, lh);
-
+                rule_type[cnt] = NO_POINTS;
                 if (element_domain == IF)
                 {
-                  if((et_space == ET_QUAD)||(et_space == ET_HEX)) geom_quad.GetIntegrationRule(order_space, dt, quad_untrafo);
-                  else geom.GetIntegrationRule(order_space, dt, quad_untrafo);
-                }
-                else if(dt == element_domain)
-                {
-                  quad_untrafo.Append(SelectIntegrationRule (et_space, order_space));
-                }
-                for(IntegrationPoint& ip2 : quad_untrafo) {
-                    if(trafo.SpaceDim() == 1) ip2.Point()[1] = t;
-                    if(trafo.SpaceDim() == 2) ip2.Point()[2] = t;
-                    ip2.SetWeight(ip2.Weight()*ip.Weight()*(t1-t0));
-                }
-                if((element_domain == IF)&&(dt == IF)){
-                    auto ir_interface  = new (lh) IntegrationRule(quad_untrafo.Size(),lh);
-                    if(trafo.SpaceDim() == 1) TransformQuadUntrafoToIRInterface<1>(quad_untrafo, trafo, geom, ir_interface);
-                    else if (trafo.SpaceDim() == 2){
-                        if(et_space == ET_QUAD){
-                            TransformQuadUntrafoToIRInterface<2>(quad_untrafo, trafo, geom_quad, ir_interface);
+                    unsigned signs = 0;
+                    if (is_simplex)
+                    {
+                        for (int k = 0; k < space_nfreedofs; k++)
+                            if (cf_lset_at_t(k) >= 0) signs |= (1u << k);
+                        if (!pattern_built[signs])
+                        {
+                            pattern_ok[signs] = BuildSimplexCutPattern(et_space, signs, dt, order_space, patterns[signs]);
+                            pattern_built[signs] = true;
                         }
-                        else TransformQuadUntrafoToIRInterface<2>(quad_untrafo, trafo, geom, ir_interface);
                     }
-                    else{
-                        if(et_space == ET_HEX){
-                            TransformQuadUntrafoToIRInterface<3>(quad_untrafo, trafo, geom_quad, ir_interface);
-                        }
-                        else TransformQuadUntrafoToIRInterface<3>(quad_untrafo, trafo, geom, ir_interface);
+                    if (is_simplex && pattern_ok[signs])
+                    {
+                        rule_type[cnt] = signs;
+                        total += patterns[signs].npoints;
                     }
-                    ir->Append(*ir_interface);
+                    else
+                    {
+                        sub_rules[cnt] = StraightCutIntegrationRule(cf_lset_at_t, trafo, dt, order_space, quad_dir_policy, lh);
+                        rule_type[cnt] = STRAIGHTCUT_RULE;
+                        total += sub_rules[cnt]->Size();
+                    }
+                }
+                else if (element_domain == dt)
+                {
+                    rule_type[cnt] = PLAIN_RULE;
+                    total += ir_plain.Size();
                 }
-                else ir->Append(quad_untrafo);
-                */
+                cnt++;
             }
         }
-        if (ir->Size() == 0)
+
+        if (total == 0)
             return nullptr;
-        else
-            return ir;
+
+        // second pass: fill the preallocated rule
+        auto ir = new (lh) IntegrationRule(total, lh);
+        int offset = 0;
+        for (int l = 0; l < nt; l++)
+        {
+            const int first = offset;
+            switch (rule_type[l])
+            {
+              case NO_POINTS:
+                continue;
+              case PLAIN_RULE:
+                for (const auto & ip : ir_plain)
+                    (*ir)[offset++] = ip;
+                break;
+              case STRAIGHTCUT_RULE:
+                for (const auto & ip : *sub_rules[l])
+                    (*ir)[offset++] = ip;
+                break;
+              default:
+                {
+                  const SimplexCutPattern & pat = patterns[rule_type[l]];
+                  FillSimplexCutRule(et_space, pat, lset_at_t.Row(l), dt, order_space, trafo, *ir, offset);
+                  offset += pat.npoints;
+                }
+            }
+            for(int k = first; k < offset; k++) {
+                if(trafo.SpaceDim() == 1) (*ir)[k].Point()[1] = times[l];
+                if(trafo.SpaceDim() == 2) (*ir)[k].Point()[2] = times[l];
+                (*ir)[k].SetWeight((*ir)[k].Weight()*tweights[l]);
+            }
+        }
+        return ir;
     }
 
     void DebugSpaceTimeCutIntegrationRule(){
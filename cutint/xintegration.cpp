@@ -1,6 +1,7 @@
 #include "xintegration.hpp"
 #include "straightcutrule.hpp"
 #include "spacetimecutrule.hpp"
+#include "highordercutrule.hpp"
 #include "../spacetime/SpaceTimeFE.hpp"
 #include "../spacetime/SpaceTimeFESpace.hpp"
 
@@ -34,6 +35,20 @@ namespace xintegration
       gflset->GetFESpace()->GetDofNrs(trafo.GetElementId(),dnums);
       FlatVector<> elvec(dnums.Size(),lh);
       gflset->GetVector().GetIndirect(dnums,elvec);
+      if (gflset->GetFESpace()->GetOrder() > 1)
+      {
+        // higher order level set function: cut rule directly on the implicit geometry
+        if (time_intorder >= 0)
+          throw Exception("Space-time cut rules require a level set of order 1 in space!");
+        const ELEMENT_TYPE et = trafo.GetElementType();
+        if (trafo.VB() == VOL && (et == ET_TRIG || et == ET_QUAD || et == ET_TET || et == ET_HEX))
+        {
+          const FiniteElement & fel = gflset->GetFESpace()->GetFE(trafo.GetElementId(), lh);
+          return HighOrderCutIntegrationRule(fel, elvec, trafo, dt, intorder, lh);
+        }
+        else
+          return CutIntegrationRule(gflset, trafo, dt, intorder, subdivlvl, lh);
+      }
       if (time_intorder >= 0) {
           FESpace* raw_FE = (gflset->GetFESpace()).get();
           SpaceTimeFESpace * st_FE = dynamic_cast<SpaceTimeFESpace*>(raw_FE);
@@ -73,7 +88,7 @@ namespace xintegration
   };
 
 
-  std::tuple<shared_ptr<CoefficientFunction>,shared_ptr<GridFunction>> CF2GFForStraightCutRule(shared_ptr<CoefficientFunction> cflset, int subdivlvl)
+  std::tuple<shared_ptr<CoefficientFunction>,shared_ptr<GridFunction>> CF2GFForStraightCutRule(shared_ptr<CoefficientFunction> cflset, int subdivlvl, bool highorder_lset)
   {
     if (subdivlvl != 0)
       return make_tuple(cflset, nullptr);
@@ -82,6 +97,9 @@ namespace xintegration
       shared_ptr<GridFunction> ret = dynamic_pointer_cast<GridFunction>(cflset);
       if ((ret != nullptr) && (ret->GetFESpace()->GetOrder() <= 1) && ( (ret->GetFESpace()->GetClassName() == "H1HighOrderFESpace") || (ret->GetFESpace()->GetClassName() == "SpaceTimeFESpace")))
         return make_tuple(nullptr, ret);
+      // higher order H1 level sets are treated by HighOrderCutIntegrationRule (opt-in)
+      else if (highorder_lset && (ret != nullptr) && (ret->GetFESpace()->GetClassName() == "H1HighOrderFESpace"))
+        return make_tuple(nullptr, ret);
       else
         return make_tuple(cflset, nullptr);
     }
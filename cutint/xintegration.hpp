@@ -22,7 +22,10 @@ namespace xintegration
                                                    int subdivlvl = 0,
                                                    SWAP_DIMENSIONS_POLICY quad_dir_policy = FIND_OPTIMAL);
 
-  std::tuple<shared_ptr<CoefficientFunction>,shared_ptr<GridFunction>> CF2GFForStraightCutRule(shared_ptr<CoefficientFunction> cflset, int subdivlvl = 0);
+  /// GridFunctions of order 1 are passed as GridFunction (straight cut rules), higher
+  /// order H1 GridFunctions only with highorder_lset (HighOrderCutIntegrationRule),
+  /// otherwise the level set stays a CoefficientFunction (evaluated on the vertices)
+  std::tuple<shared_ptr<CoefficientFunction>,shared_ptr<GridFunction>> CF2GFForStraightCutRule(shared_ptr<CoefficientFunction> cflset, int subdivlvl = 0, bool highorder_lset = false);
   
   /// (in order to use std::set-features)
   template< int SD>
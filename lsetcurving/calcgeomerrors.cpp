@@ -7,6 +7,8 @@
 #include "calcgeomerrors.hpp"
 #include "../cutint/xintegration.hpp"
 #include "shiftintegrators.hpp"
+#include "../xfem/cutinfo.hpp"
+#include "../utils/ngsxstd.hpp"
 
 using namespace xintegration;
 
@@ -39,15 +41,16 @@ namespace ngcomp
 
 
   template<int D>
-  void CalcDistances (shared_ptr<CoefficientFunction> lset_ho, shared_ptr<GridFunction> gf_lset_p1, shared_ptr<GridFunction> deform, StatisticContainer & cont, LocalHeap & lh, double refine_threshold, bool abs_ref_threshold){
+  void CalcDistances (shared_ptr<CoefficientFunction> lset_ho, shared_ptr<GridFunction> gf_lset_p1, shared_ptr<GridFunction> deform, StatisticContainer & cont, LocalHeap & clh, double refine_threshold, bool abs_ref_threshold, shared_ptr<CutInformation> cutinfo){
     static Timer time_fct ("CalcDistances");
     RegionTimer reg (time_fct);
 
     auto ma = deform->GetMeshAccess();
 
+    int ne=ma->GetNE();
+
     if (refine_threshold > 0)
     {
-      int ne = ma->GetNE();
       for (int i = 0; i < ne; i++)
         Ng_SetRefinementFlag (i+1, 0);
       if (D==3)
@@ -58,59 +61,81 @@ namespace ngcomp
       }
     }
 
-    int ne=ma->GetNE();
-
     int order = deform->GetFESpace()->GetOrder();
 
-    double lset_error_l1 = 0.0;
-    double lset_error_max = 0.0;
-    Vec<D> point_of_max_lset_error;
-    IntegrationPoint ip_of_max_lset_error;
-    // ofstream pointsout("pointsout");
-
-    ProgressOutput progress (ma, "calc distance on element", ma->GetNE());
+    // elements that have to be visited: the cut elements of the CutInfo (if
+    // provided), otherwise all elements (band check in the loop below)
+    Array<int> elems;
+    if (cutinfo)
+    {
+      if (cutinfo->GetMesh() != ma)
+        throw Exception("CalcDistances: CutInfo lives on a different mesh");
+      auto ba_if = cutinfo->GetElementsOfDomainType(IF,VOL);
+      for (int elnr = 0; elnr < ne; elnr++)
+        if (ba_if->Test(elnr))
+          elems.Append(elnr);
+    }
+    else
+    {
+      elems.SetSize(ne);
+      for (int elnr = 0; elnr < ne; elnr++)
+        elems[elnr] = elnr;
+    }
 
-    int marked = 0;
+    // partial results are reduced per chunk of elements and the chunks are
+    // merged in a fixed order afterwards, so that the result does not depend
+    // on the number of threads or the scheduling
+    constexpr int chunk_size = 32;
+    const int nchunks = (elems.Size() + chunk_size - 1) / chunk_size;
+    Array<double> chunk_l1(nchunks);
+    Array<double> chunk_max(nchunks);
+    chunk_l1 = 0.0;
+    chunk_max = 0.0;
 
-    // IterateElements
-    //   (*(gf_lset_p1->GetFESpace()), VOL, clh,  [&] (FESpace::Element el, LocalHeap & lh)
-    //    {
-    for (auto el : gf_lset_p1->GetFESpace()->Elements(VOL,lh))
-    {
-      int elnr = el.Nr();
-      HeapReset hr(lh);
-      progress.Update ();
+    BitArray marked_els(ne);
+    marked_els.Clear();
 
-      Ngs_Element ngel = ma->GetElement(el);
-      ELEMENT_TYPE eltype = ngel.GetType();
-      Array<int> dofs;
-      gf_lset_p1->GetFESpace()->GetDofNrs(el,dofs);
-      FlatVector<> lset_vals_p1(dofs.Size(),lh);
-      gf_lset_p1->GetVector().GetIndirect(dofs,lset_vals_p1);
+    ProgressOutput progress (ma, "calc distance on element", elems.Size());
 
-      ElementTransformation * eltrans_curved;
-      ElementTransformation * eltrans;
+    // the straight transformations are needed below, a deformation that is
+    // active on the mesh is unset during the loop and restored afterwards
+    shared_ptr<GridFunction> mesh_deform = ma->GetDeformation();
+    ma->SetDeformation(nullptr);
 
-// #pragma omp critical(deform)
-      {
-        ma->SetDeformation(deform);
-        eltrans_curved = &ma->GetTrafo (el, lh);
-      }
-// #pragma omp critical(deform)
+    IterateRange
+      (nchunks, clh, [&] (int chunk, LocalHeap & lh)
+    {
+      double lset_error_l1 = 0.0;
+      double lset_error_max = 0.0;
+      const int first = chunk * chunk_size;
+      const int next = min(first + chunk_size, int(elems.Size()));
+      for (int k = first; k < next; k++)
       {
-        ma->SetDeformation(nullptr);
-        eltrans = &ma->GetTrafo (el, lh);
-      }
-      IntegrationPoint ipzero(0.0,0.0,0.0);
-      MappedIntegrationPoint<D,D> mx0(ipzero,*eltrans);
+        HeapReset hr(lh);
+        progress.Update ();
+        ElementId el(VOL,elems[k]);
 
+        Array<int> dofs;
+        gf_lset_p1->GetFESpace()->GetDofNrs(el,dofs);
+        FlatVector<> lset_vals_p1(dofs.Size(),lh);
+        gf_lset_p1->GetVector().GetIndirect(dofs,lset_vals_p1);
+
+        if (!cutinfo && !ElementInRelevantBand(lset_vals_p1, 0.0, 0.0))
+          continue;
+
+        // straight transformation and the curved one with the deformation
+        // added per element
+        const ElementTransformation * eltrans = &ma->GetTrafo (el, lh);
+        const ElementTransformation * eltrans_curved = &eltrans->AddDeformation (deform.get(), lh);
+        IntegrationPoint ipzero(0.0,0.0,0.0);
+        MappedIntegrationPoint<D,D> mx0(ipzero,*eltrans);
 
-      if (ElementInRelevantBand(lset_vals_p1, 0.0, 0.0))
-      {
         const IntegrationRule * ir = CreateCutIntegrationRule(nullptr, gf_lset_p1, *eltrans,
                                                               IF, 2*order, -1, lh, 0);
+        if (ir == nullptr)
+          continue;
         const IntegrationRule & fquad_if(*ir);
-        
+
         bool mark_this_el = false;
 
         for (int i = 0; i < fquad_if.Size(); ++i)
@@ -123,20 +148,10 @@ namespace ngcomp
           MappedIntegrationPoint<D,D> mipy(ipy,*eltrans);
           // now mip.GetPoint() == mipy.GetPoint()
 
-          // const double lset_val_transf_p1 = gf_lset_p1->Evaluate(mip);
-
           const double lset_val = lset_ho->Evaluate(mipy);
 
-          // pointsout << mip.GetPoint()[0] << " " << mip.GetPoint()[1] << " " <<  abs(lset_val) << endl;
           const double h = std::pow(mipy.GetJacobiDet(),1.0/D);
-// #pragma omp critical(max)
-          if (abs(lset_val) > lset_error_max)
-          {
-            lset_error_max = abs(lset_val);
-            point_of_max_lset_error = mip.GetPoint();
-            ip_of_max_lset_error = ip;
-          }
-
+          lset_error_max = max(lset_error_max, abs(lset_val));
 
           if (refine_threshold > 0)
             if ( (abs_ref_threshold && (abs(lset_val) > refine_threshold))
@@ -145,34 +160,37 @@ namespace ngcomp
               mark_this_el = true;
             }
 
-          const double weight = mip.GetWeight();
-
-// #pragma omp atomic
-          lset_error_l1 += weight * abs(lset_val);
-          // surface += weight;
+          lset_error_l1 += mip.GetWeight() * abs(lset_val);
         }
-        // pointsout << endl;
-        // delete cquad;
 
         if (mark_this_el)
-        {
-          Ng_SetRefinementFlag (elnr+1, 1);
-// #pragma omp atomic
-          marked++;
-        }
+          marked_els.SetBitAtomic(el.Nr());
       }
-    }
-    // });
+      chunk_l1[chunk] = lset_error_l1;
+      chunk_max[chunk] = lset_error_max;
+    });
 
     progress.Done();
+    ma->SetDeformation(mesh_deform);
+
+    double lset_error_l1 = 0.0;
+    double lset_error_max = 0.0;
+    for (int chunk = 0; chunk < nchunks; chunk++)
+    {
+      lset_error_l1 += chunk_l1[chunk];
+      lset_error_max = max(lset_error_max, chunk_max[chunk]);
+    }
 
     if (refine_threshold > 0)
-      cout << " marked " << marked << " elements for refinement " << endl;
+    {
+      for (int elnr = 0; elnr < ne; elnr++)
+        if (marked_els.Test(elnr))
+          Ng_SetRefinementFlag (elnr+1, 1);
+      cout << " marked " << marked_els.NumSet() << " elements for refinement " << endl;
+    }
 
     cont.ErrorL1Norm.Append(lset_error_l1);
     cont.ErrorMaxNorm.Append(lset_error_max);
-    // cout << " point_of_max_lset_error = " << point_of_max_lset_error << endl;
-    // cout << " ip_of_max_lset_error = " << ip_of_max_lset_error << endl;
   }
 
 
@@ -230,6 +248,7 @@ namespace ngcomp
         deform->GetVector().GetIndirect(dnums,elvec_as_vec);
 
         IntegrationRule ir = SelectIntegrationRule (eltrans.GetElementType(), 2*scafe.Order());
+        const LsetEvaluator<D> lseteval = MakeLsetEvaluator<D>(lset_ho, eltrans, lh);
         for (int l = 0; l < ir.GetNIP(); l++)
         {
           MappedIntegrationPoint<D,D> mip(ir[l], eltrans);
@@ -261,7 +280,7 @@ namespace ngcomp
 
             double goal_val = gf_lset_p1->Evaluate(mip);
             Vec<D> final_point;
-            SearchCorrespondingPoint<D>(LsetEvaluator<D>(lset_ho, eltrans),
+            SearchCorrespondingPoint<D>(lseteval,
                                         orig_point, goal_val,
                                         trafo_of_normals, normal, false,
                                         final_point, lh);
@@ -377,6 +396,8 @@ namespace ngcomp
         SelectIntegrationRule (etfacet, 2*deform->GetFESpace()->GetOrder());
 
 
+      const LsetEvaluator<D> lsetevals [] = {MakeLsetEvaluator<D>(lset_ho, eltrans1, lh),
+                                              MakeLsetEvaluator<D>(lset_ho, eltrans2, lh)};
       for (int l = 0; l < ir_facet.GetNIP(); l++)
       {
         Vec<D> deform_at_point [2];
@@ -416,7 +437,7 @@ namespace ngcomp
 
             double goal_val = gf_lset_p1->Evaluate(mip);
             Vec<D> final_point;
-            SearchCorrespondingPoint<D>(LsetEvaluator<D>(lset_ho, *eltransj[j]),
+            SearchCorrespondingPoint<D>(lsetevals[j],
                                         orig_point, goal_val,
                                         trafo_of_normals, normal, false,
                                         final_point, lh);
@@ -446,10 +467,10 @@ namespace ngcomp
 
   template void CalcDistances<2>(shared_ptr<CoefficientFunction> , shared_ptr<GridFunction> ,
                                  shared_ptr<GridFunction> , StatisticContainer & , LocalHeap & ,
-                                 double , bool );
+                                 double , bool , shared_ptr<CutInformation> );
   template void CalcDistances<3>(shared_ptr<CoefficientFunction> , shared_ptr<GridFunction> ,
                                  shared_ptr<GridFunction> , StatisticContainer & , LocalHeap & ,
-                                 double , bool );
+                                 double , bool , shared_ptr<CutInformation> );
   template void CalcDeformationError<2> (shared_ptr<CoefficientFunction> , shared_ptr<GridFunction> ,
                                          shared_ptr<GridFunction> , shared_ptr<CoefficientFunction> ,
                                          StatisticContainer & , LocalHeap & , double , double );
@@ -24,8 +24,13 @@ namespace ngcomp
     Array<double> ErrorMisc;
   };
   
+  class CutInformation;
+
+  /// distance (L1 and max) of the isoparametric interface to the zero level of gf_lset_ho;
+  /// only the elements cut by gf_lset_p1 are visited; if cutinfo is given, its
+  /// IF elements are taken instead of checking all elements
   template <int D>
-  void CalcDistances (shared_ptr<CoefficientFunction> gf_lset_ho, shared_ptr<GridFunction> gf_lset_p1, shared_ptr<GridFunction> deform, StatisticContainer & cont, LocalHeap & lh, double define_threshold = -1.0, bool abs_ref_threshold = false);
+  void CalcDistances (shared_ptr<CoefficientFunction> gf_lset_ho, shared_ptr<GridFunction> gf_lset_p1, shared_ptr<GridFunction> deform, StatisticContainer & cont, LocalHeap & lh, double define_threshold = -1.0, bool abs_ref_threshold = false, shared_ptr<CutInformation> cutinfo = nullptr);
 
   template<int D>
   void CalcDeformationError (shared_ptr<CoefficientFunction> lset_ho, shared_ptr<GridFunction> gf_lset_p1, shared_ptr<GridFunction> deform, shared_ptr<CoefficientFunction> qn, StatisticContainer & cont, LocalHeap & lh, double, double);
@@ -1,4 +1,5 @@
 #include "calcpointshift.hpp"
+#include <comp.hpp>
 
 // using namespace ngsolve;
 using namespace ngfem;
@@ -80,6 +81,96 @@ namespace ngfem
   }
 
 
+  template<int D>
+  void LsetEvaluator<D>::EvaluateWithGrad(const IntegrationPoint & ip, double & val, Vec<D> & grad,
+                                          LocalHeap & lh) const
+  {
+    HeapReset hr (lh);
+    IntegrationRule ir(1, const_cast<IntegrationPoint*>(&ip));
+    FlatMatrixFixWidth<D+1> vals_grads(1, lh);
+    EvaluateWithGrad(ir, vals_grads, lh);
+    val = vals_grads(0,0);
+    for (int d = 0; d < D; d++)
+      grad(d) = vals_grads(0,d+1);
+  }
+
+  template<int D>
+  void LsetEvaluator<D>::EvaluateWithGrad(const IntegrationRule & ir, FlatMatrixFixWidth<D+1> vals_grads,
+                                          LocalHeap & lh) const
+  {
+    static Timer time_fct ("LsetEvaluator::EvaluateWithGrad");
+    RegionTimer reg (time_fct);
+
+    if (scafe)
+    {
+      // one pass over the points sets up shape and dshape of each point side
+      // by side (column i*(D+1) + k is entry (i,k) of vals_grads), values and
+      // gradients of all points are then one product with the coefficients
+      HeapReset hr (lh);
+      const int np = ir.Size();
+      FlatMatrix<> shapes(scafe->GetNDof(), np*(D+1), lh);
+      for (int i = 0; i < np; i++)
+      {
+        scafe->CalcShape(ir[i], shapes.Col(i*(D+1)));
+        scafe->CalcDShape(ir[i], shapes.Cols(i*(D+1)+1, (i+1)*(D+1)));
+      }
+      FlatVector<> vals_grads_vec(np*(D+1), &vals_grads(0,0));
+      vals_grads_vec = Trans(shapes) * scavalues;
+    }
+    else
+    {
+      // central differences in reference coordinates for all points with one
+      // evaluation of the coefficient on the rule of all shifted points
+      HeapReset hr (lh);
+      constexpr double eps = 1e-7;
+      const int np = ir.Size();
+      IntegrationRule ir_all(np*(2*D+1), lh);
+      for (int i = 0; i < np; i++)
+      {
+        ir_all[i*(2*D+1)] = ir[i];
+        for (int d = 0; d < D; d++)
+          for (int side = 0; side < 2; side++)
+          {
+            IntegrationPoint & ipd = ir_all[i*(2*D+1)+1+2*d+side];
+            ipd = ir[i];
+            ipd(d) += side == 0 ? -eps : eps;
+          }
+      }
+      MappedIntegrationRule<D,D> mir(ir_all, *eltrans, lh);
+      FlatMatrix<> vals(ir_all.Size(), 1, lh);
+      coef->Evaluate(mir, vals);
+      for (int i = 0; i < np; i++)
+      {
+        const int first = i*(2*D+1);
+        vals_grads(i,0) = vals(first,0);
+        for (int d = 0; d < D; d++)
+          vals_grads(i,d+1) = (vals(first+2+2*d,0) - vals(first+1+2*d,0)) / (2*eps);
+      }
+    }
+  }
+
+  template<int D>
+  LsetEvaluator<D> MakeLsetEvaluator(shared_ptr<CoefficientFunction> coef,
+                                     const ElementTransformation & eltrans, LocalHeap & lh)
+  {
+    auto gf = dynamic_pointer_cast<GridFunction>(coef);
+    if (gf && gf->GetFESpace()->GetDimension() == 1 && eltrans.VB() == VOL)
+    {
+      const ElementId ei = eltrans.GetElementId();
+      auto scafe = dynamic_cast<const ScalarFiniteElement<D>*>(&gf->GetFESpace()->GetFE(ei, lh));
+      if (scafe)
+      {
+        Array<DofId> dnums(0, lh);
+        gf->GetFESpace()->GetDofNrs(ei, dnums);
+        FlatVector<> values(dnums.Size(), lh);
+        gf->GetVector().GetIndirect(dnums, values);
+        return LsetEvaluator<D>(*scafe, values);
+      }
+    }
+    return LsetEvaluator<D>(coef, eltrans);
+  }
+
+
   bool ElementInRelevantBand (shared_ptr<CoefficientFunction> lset_p1,
                               const ElementTransformation & eltrans,
                               double lower_lset_bound, 
@@ -140,69 +231,165 @@ namespace ngfem
 
 
   
+  static atomic<size_t> searches_total(0);
+  static atomic<size_t> iterations_total(0);
+  static atomic<size_t> max_iterations_total(0);
+  static atomic<size_t> failures_total(0);
+
+  static void AddPointSearchStatistics (const PointSearchStatistics & local)
+  {
+    searches_total += local.searches;
+    iterations_total += local.iterations;
+    failures_total += local.failures;
+    size_t prev = max_iterations_total;
+    while (prev < local.max_iterations
+           && !max_iterations_total.compare_exchange_weak(prev, local.max_iterations))
+      ;
+  }
+
+  PointSearchStatistics GetPointSearchStatistics ()
+  {
+    PointSearchStatistics stats;
+    stats.searches = searches_total;
+    stats.iterations = iterations_total;
+    stats.max_iterations = max_iterations_total;
+    stats.failures = failures_total;
+    return stats;
+  }
+
+  void ResetPointSearchStatistics ()
+  {
+    searches_total = 0;
+    iterations_total = 0;
+    max_iterations_total = 0;
+    failures_total = 0;
+  }
+
   template<int D>
-  void SearchCorrespondingPoint (
-    const LsetEvaluator<D> & lseteval,                               //<- lset_ho
-    const Vec<D> & init_point, double goal_val,                      //<- init.point and goal val
-    const Mat<D> & trafo_of_normals, const Vec<D> & init_search_dir, //<- search direction
+  int SearchCorrespondingPoints (
+    const LsetEvaluator<D> & lseteval,
+    FlatMatrixFixWidth<D> init_points, FlatVector<> goal_vals,
+    FlatArray<Mat<D>> trafo_of_normals, FlatMatrixFixWidth<D> init_search_dirs,
     bool dynamic_search_dir,
-    Vec<D> & final_point, LocalHeap & lh,                            //<- result and localheap
-    double * n_totalits,
-    double * n_maxits)
+    FlatMatrixFixWidth<D> final_points, LocalHeap & lh,
+    PointSearchStatistics * stats,
+    FlatMatrixFixWidth<D> start_points)
   {
-    static Timer time_not_conv ("SearchCorrespondingPoint::not converged");
-    static Timer time_conv ("SearchCorrespondingPoint::converged");
     static Timer time_its ("SearchCorrespondingPoint::iterations");
     static Timer time_fct ("SearchCorrespondingPoint");
     RegionTimer reg (time_fct);
-    
+
     HeapReset hr(lh);
-      
-    IntegrationPoint curr_ip;
-    for (int d = 0; d < D; ++d) curr_ip(d) = init_point(d);
+    constexpr int maxits = 20;
+    const int np = init_points.Height();
 
-    Vec<D> search_dir = init_search_dir;
+    if (start_points.Height() == np)
+      final_points = start_points;
+    else
+      final_points = init_points;
+    FlatMatrixFixWidth<D> search_dirs(np, lh);
+    search_dirs = init_search_dirs;
+
+    // unconverged points (compressed after every iteration)
+    FlatArray<int> active(np, lh);
+    for (int i = 0; i < np; i++)
+      active[i] = i;
+    int nactive = np;
+
+    PointSearchStatistics local;
+    local.searches = np;
+
+    IntegrationRule ir(np, lh);
+    for (int i = 0; i < np; i++)
+      ir[i] = IntegrationPoint(0.0, 0.0, 0.0, 0.0);
+    FlatMatrixFixWidth<D+1> vals_grads(np, lh);
     int it = 0;
-    for (it = 0; it < 20; ++it)
+    for (it = 0; it < maxits && nactive > 0; ++it)
     {
       RegionTimer reg_its (time_its);
-      const double curr_val = lseteval.Evaluate(curr_ip,lh); // InnerProduct(shape, sca_values);
-      const Vec<D> curr_grad = lseteval.EvaluateGrad(curr_ip,lh); //Trans(dshape) * sca_values;
-      const double curr_defect = goal_val - curr_val;
-      if (abs(curr_defect) < 1e-14) // && it > 2)
-        break;
+      IntegrationRule ir_active(nactive, &ir[0]);
+      for (int k = 0; k < nactive; k++)
+        for (int d = 0; d < D; ++d)
+          ir_active[k](d) = final_points(active[k],d);
+      FlatMatrixFixWidth<D+1> curr(nactive, &vals_grads(0,0));
+      lseteval.EvaluateWithGrad(ir_active, curr, lh);
 
-      if (dynamic_search_dir)
+      int nnext = 0;
+      for (int k = 0; k < nactive; k++)
       {
-        search_dir = trafo_of_normals * curr_grad;
-        // search_dir /= L2Norm(search_dir);
-      }
-        
-      const double dphidn = InnerProduct(curr_grad,search_dir);
+        const int i = active[k];
+        const double curr_defect = goal_vals(i) - curr(k,0);
+        if (abs(curr_defect) < 1e-14)
+        {
+          local.iterations += it;
+          local.max_iterations = max2(local.max_iterations, size_t(it));
+          continue;
+        }
 
-      for (int d = 0; d < D; ++d)
-        curr_ip(d) += curr_defect / dphidn * search_dir(d);
+        Vec<D> curr_grad;
+        for (int d = 0; d < D; ++d)
+          curr_grad(d) = curr(k,d+1);
+        if (dynamic_search_dir)
+          search_dirs.Row(i) = trafo_of_normals[i] * curr_grad;
+
+        Vec<D> search_dir = search_dirs.Row(i);
+        const double dphidn = InnerProduct(curr_grad,search_dir);
+        final_points.Row(i) += curr_defect / dphidn * search_dir;
+        active[nnext++] = i;
+      }
+      nactive = nnext;
     }
 
-    if (n_totalits)
-#pragma omp critical (totalits)
-      *n_totalits += it;
-#pragma omp critical (maxits)
-    if (n_maxits)
-      *n_maxits = max2((double)it,*n_maxits);
+    // not converged: keep the initial point
+    for (int k = 0; k < nactive; k++)
+      final_points.Row(active[k]) = init_points.Row(active[k]);
+    local.iterations += size_t(maxits) * nactive;
+    if (nactive > 0)
+      local.max_iterations = maxits;
+    local.failures = nactive;
 
-    if (it == 20){
-      RegionTimer reg (time_not_conv);
-      
-      std::cout << " SearchCorrespondingPoint:: did not converge " << std::endl;
-      // getchar();
-      final_point = init_point;
-    }
-    else
+    AddPointSearchStatistics(local);
+    if (stats)
     {
-      RegionTimer reg (time_conv);
-      for (int d = 0; d < D; ++d) final_point(d) = curr_ip(d);
+      stats->searches += local.searches;
+      stats->iterations += local.iterations;
+      stats->max_iterations = max2(stats->max_iterations, local.max_iterations);
+      stats->failures += local.failures;
     }
+    return nactive;
+  }
+
+  template<int D>
+  void SearchCorrespondingPoint (
+    const LsetEvaluator<D> & lseteval,                               //<- lset_ho
+    const Vec<D> & init_point, double goal_val,                      //<- init.point and goal val
+    const Mat<D> & trafo_of_normals, const Vec<D> & init_search_dir, //<- search direction
+    bool dynamic_search_dir,
+    Vec<D> & final_point, LocalHeap & lh,                            //<- result and localheap
+    double * n_totalits,
+    double * n_maxits)
+  {
+    HeapReset hr(lh);
+    FlatMatrixFixWidth<D> init_points(1, lh);
+    FlatMatrixFixWidth<D> search_dirs(1, lh);
+    FlatMatrixFixWidth<D> final_points(1, lh);
+    FlatVector<> goal_vals(1, lh);
+    FlatArray<Mat<D>> trafos(1, lh);
+    init_points.Row(0) = init_point;
+    search_dirs.Row(0) = init_search_dir;
+    goal_vals(0) = goal_val;
+    trafos[0] = trafo_of_normals;
+
+    PointSearchStatistics stats;
+    SearchCorrespondingPoints<D>(lseteval, init_points, goal_vals, trafos, search_dirs,
+                                 dynamic_search_dir, final_points, lh, &stats);
+    final_point = final_points.Row(0);
+
+    // counters of the caller (not synchronized)
+    if (n_totalits)
+      *n_totalits += stats.iterations;
+    if (n_maxits)
+      *n_maxits = max2((double)stats.max_iterations,*n_maxits);
   }
 
 
@@ -213,7 +400,13 @@ namespace ngfem
 
   template class LsetEvaluator<2>;
   template class LsetEvaluator<3>;
+
+  template LsetEvaluator<2> MakeLsetEvaluator<2> (shared_ptr<CoefficientFunction>, const ElementTransformation &, LocalHeap &);
+  template LsetEvaluator<3> MakeLsetEvaluator<3> (shared_ptr<CoefficientFunction>, const ElementTransformation &, LocalHeap &);
   
+  template int SearchCorrespondingPoints<2> (const LsetEvaluator<2> &, FlatMatrixFixWidth<2>, FlatVector<>, FlatArray<Mat<2>>, FlatMatrixFixWidth<2>, bool, FlatMatrixFixWidth<2>, LocalHeap &, PointSearchStatistics *, FlatMatrixFixWidth<2>);
+  template int SearchCorrespondingPoints<3> (const LsetEvaluator<3> &, FlatMatrixFixWidth<3>, FlatVector<>, FlatArray<Mat<3>>, FlatMatrixFixWidth<3>, bool, FlatMatrixFixWidth<3>, LocalHeap &, PointSearchStatistics *, FlatMatrixFixWidth<3>);
+
   template void SearchCorrespondingPoint<2> (const LsetEvaluator<2> &, const Vec<2> &, double, const Mat<2> &, const Vec<2> &, bool, Vec<2> &, LocalHeap &, double *, double *);
   template void SearchCorrespondingPoint<3> (const LsetEvaluator<3> &, const Vec<3> &, double, const Mat<3> &, const Vec<3> &, bool, Vec<3> &, LocalHeap &, double *, double *);
   
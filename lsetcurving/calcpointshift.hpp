@@ -30,8 +30,19 @@ namespace ngfem
 
     double Evaluate(const IntegrationPoint & ip, LocalHeap & lh) const;
     Vec<D> EvaluateGrad(const IntegrationPoint & ip, LocalHeap & lh) const;
+    /// value and (reference) gradient at ip
+    void EvaluateWithGrad(const IntegrationPoint & ip, double & val, Vec<D> & grad, LocalHeap & lh) const;
+    /// value and (reference) gradient at all points of ir, row i of vals_grads: (value, gradient)
+    void EvaluateWithGrad(const IntegrationRule & ir, FlatMatrixFixWidth<D+1> vals_grads, LocalHeap & lh) const;
   };
 
+  /// Evaluator of the level set coef on the element of eltrans. Scalar H1-type
+  /// GridFunctions are evaluated with their finite element (exact gradients,
+  /// coefficients are stored in lh), other CoefficientFunctions pointwise.
+  template<int D>
+  LsetEvaluator<D> MakeLsetEvaluator(shared_ptr<CoefficientFunction> coef,
+                                     const ElementTransformation & eltrans, LocalHeap & lh);
+
 
 
 
@@ -45,6 +56,36 @@ namespace ngfem
                               double upper_lset_bound);
   
   
+  /// statistics of the point searches. Every (batched) search collects them
+  /// locally and adds them to the global counters once at the end.
+  struct PointSearchStatistics
+  {
+    size_t searches = 0;
+    size_t iterations = 0;
+    size_t max_iterations = 0;
+    size_t failures = 0;
+  };
+
+  /// accumulated statistics of all searches since the last reset
+  PointSearchStatistics GetPointSearchStatistics ();
+  void ResetPointSearchStatistics ();
+
+  /// Newton search for all points of an element at once. The level set values
+  /// and gradients of all unconverged points are evaluated together. Points
+  /// that do not converge keep their initial position and are counted as
+  /// failures (return value). If start_points are given, the iteration starts
+  /// there instead of at the initial points.
+  template<int D>
+  int SearchCorrespondingPoints (
+    const LsetEvaluator<D> & lseteval,                                     //<- lset_ho
+    FlatMatrixFixWidth<D> init_points, FlatVector<> goal_vals,             //<- init.points and goal vals
+    FlatArray<Mat<D>> trafo_of_normals, FlatMatrixFixWidth<D> init_search_dirs, //<- search directions
+    bool dynamic_search_dir,
+    FlatMatrixFixWidth<D> final_points, LocalHeap & lh,                    //<- result and localheap
+    PointSearchStatistics * stats = nullptr,
+    FlatMatrixFixWidth<D> start_points = FlatMatrixFixWidth<D>(0,(double*)nullptr)
+    );
+
   template<int D>
   void SearchCorrespondingPoint (
     const LsetEvaluator<D> & lseteval,                               //<- lset_ho
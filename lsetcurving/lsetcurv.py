@@ -105,7 +105,12 @@ The computed deformation depends on different options:
         self.deform = GridFunction(self.v_def, "deform")
         self.heapsize = heapsize
 
-    def CalcDeformation(self, levelset, ba =None, blending=None):
+        # lset_p1 of the last call to CalcDeformation and the settings of that call
+        # (for incremental updates)
+        self.lset_p1_old = None
+        self.settings_old = None
+
+    def CalcDeformation(self, levelset, ba =None, blending=None, incremental=False, update_tol=0.0):
         """
 Compute the mesh deformation, s.t. isolines on cut elements of lset_p1 (the piecewise linear
 approximation) are mapped towards the corresponding isolines of a given function
@@ -128,6 +133,16 @@ blending : None/string/CoefficientFunction
      blending function that is 0 at the zero level set (of lset_p1) and increases like a fourth
      order polynomial with lset_p1. It is scaled with h, so that value 1 is not reached within cut
      elements.
+
+incremental : boolean
+  Keep the deformation of the last call and only recompute it on elements where lset_p1 changed by
+  more than update_tol or which entered or left the band of relevant elements. The last deformation
+  serves as initial guess for the point searches. Only used if neither the last nor this call is
+  restricted by ba or uses a blending CoefficientFunction, and if the blending option, the bounds,
+  the threshold and the mesh did not change. Otherwise the deformation is computed from scratch.
+
+update_tol : float
+  tolerance for changes of lset_p1 in the incremental mode.
         """
         self.v_ho.Update()
         self.lset_ho.Update()
@@ -141,6 +156,16 @@ blending : None/string/CoefficientFunction
         self.lset_ho.Set(levelset)
         self.qn.Set(self.lset_ho.Deriv())
         InterpolateToP1(self.lset_ho,self.lset_p1,eps_perturbation=self.eps_perturbation)
+
+        # the last deformation can only be reused if it was computed on all elements
+        # with the same settings. Blending functions given as CoefficientFunction can
+        # not be compared, those deformations are never reused.
+        if ba is None and (blending is None or isinstance(blending, str)):
+            settings = (blending if blending is not None else "none", self.order_deform,
+                        self.lset_lower_bound, self.lset_upper_bound, self.threshold)
+        else:
+            settings = None
+
         if blending == None or blending == "none":
             blending = CoefficientFunction(0.0)
         elif blending == "quadratic":
@@ -150,6 +175,11 @@ blending : None/string/CoefficientFunction
             scale=sqrt(self.lset_p1.space.mesh.dim) * specialcf.mesh_size
             blending = self.lset_p1*self.lset_p1*self.lset_p1*self.lset_p1/(scale*scale*scale*scale)
             
+        lset_p1_old = None
+        if incremental and settings is not None and settings == self.settings_old \
+           and self.lset_p1_old is not None and len(self.lset_p1_old) == len(self.lset_p1.vec):
+            lset_p1_old = self.lset_p1_old
+
         ProjectShift(self.lset_ho,
                      self.lset_p1,
                      self.deform,
@@ -159,7 +189,17 @@ blending : None/string/CoefficientFunction
                      lower=self.lset_lower_bound,
                      upper=self.lset_upper_bound,
                      threshold=self.threshold,
-                     heapsize=self.heapsize)
+                     heapsize=self.heapsize,
+                     lset_p1_old=lset_p1_old,
+                     update_tol=update_tol)
+
+        self.settings_old = settings
+        if settings is None:
+            self.lset_p1_old = None
+        else:
+            if self.lset_p1_old is None or len(self.lset_p1_old) != len(self.lset_p1.vec):
+                self.lset_p1_old = self.lset_p1.vec.CreateVector()
+            self.lset_p1_old.data = self.lset_p1.vec
         return self.deform
 
 
@@ -169,18 +209,20 @@ blending : None/string/CoefficientFunction
     #     """
     #     CalcDistances(levelset,self.lset_p1,self.deform,lset_stats)
 
-    def CalcMaxDistance(self, levelset, heapsize=None):
+    def CalcMaxDistance(self, levelset, heapsize=None, cutinfo=None):
         """
 Compute approximated distance between of the isoparametrically obtained geometry.
 
 See documentation of xfem.CalcMaxDistance 
         """
         if (heapsize == None):
-            return CalcMaxDistance(levelset,self.lset_p1,self.deform,heapsize=self.heapsize)
-        else:
+            heapsize = self.heapsize
+        if cutinfo is None:
             return CalcMaxDistance(levelset,self.lset_p1,self.deform,heapsize=heapsize)
+        else:
+            return CalcMaxDistance(levelset,self.lset_p1,self.deform,heapsize=heapsize,cutinfo=cutinfo)
         
-    def MarkForRefinement(self, levelset = None, refine_threshold = 0.1, absolute = False):
+    def MarkForRefinement(self, levelset = None, refine_threshold = 0.1, absolute = False, cutinfo = None):
         """
 Marks elements for refinement where the geometry approximation is larger than a prescrbed relative
 (or absolute) (to the mesh size) error. This will lead to a refinement in zones with high curvature.
@@ -196,11 +238,17 @@ Parameters:
 
   absolute : boolean
     decides if the refine_threshold is an absolute value or if it is weighted with the mesh size
+
+  cutinfo : xfem.CutInfo/None
+    CutInfo updated with self.lset_p1. If given, only its cut elements are checked.
         """
         lset_stats = StatisticContainer()
         if levelset==None:
             levelset = self.lset_ho
-        CalcDistances(lset_ho=levelset,lset_p1=self.lset_p1,deform=self.deform,stats=lset_stats,refine_threshold=refine_threshold,absolute=absolute)
+        if cutinfo is None:
+            CalcDistances(lset_ho=levelset,lset_p1=self.lset_p1,deform=self.deform,stats=lset_stats,refine_threshold=refine_threshold,absolute=absolute)
+        else:
+            CalcDistances(lset_ho=levelset,lset_p1=self.lset_p1,deform=self.deform,stats=lset_stats,refine_threshold=refine_threshold,absolute=absolute,cutinfo=cutinfo)
         
 #     def CalcDeformationError(self, deform_stats):
 #         """
@@ -10,7 +10,41 @@
 namespace ngcomp
 { 
 
-  void RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, LocalHeap & lh){
+  shared_ptr<BitArray> MarkAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound){
+    static Timer time_fct ("MarkAtLevelSet");
+    RegionTimer reg (time_fct);
+
+    auto ma = gf_lset_p1->GetMeshAccess();
+    int ne=ma->GetNE();
+
+    auto marked = make_shared<BitArray>(ne);
+    marked->Clear();
+
+    ParallelForRange (Range(ne), [&](IntRange r)
+    {
+      Array<int> dnums_lset_p1;
+      Vector<> lset_vals_p1;
+      for (int elnr : r)
+      {
+        // element only measure error if "at the interface"
+        gf_lset_p1->GetFESpace()->GetDofNrs(ElementId(VOL,elnr),dnums_lset_p1);
+        lset_vals_p1.SetSize(dnums_lset_p1.Size());
+        gf_lset_p1->GetVector().GetIndirect(dnums_lset_p1,lset_vals_p1);
+
+        if (ElementInRelevantBand(lset_vals_p1, lower_lset_bound, upper_lset_bound))
+          marked->SetBitAtomic(elnr);
+      }
+    });
+    return marked;
+  }
+
+  shared_ptr<BitArray> RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, LocalHeap & lh, bool mark_only){
+    static Timer time_fct ("RefineAtLevelSet");
+    RegionTimer reg (time_fct);
+
+    auto marked = MarkAtLevelSet(gf_lset_p1, lower_lset_bound, upper_lset_bound);
+    if (mark_only)
+      return marked;
 
     auto ma = gf_lset_p1->GetMeshAccess();
     const int D = ma->GetDimension();
@@ -22,23 +56,10 @@ namespace ngcomp
     }
 
     int ne=ma->GetNE();
-      
     for (int elnr = 0; elnr < ne; ++elnr)
-    {
-      HeapReset hr(lh);
-      // element only measure error if "at the interface"
-      Array<int> dnums_lset_p1;
-      gf_lset_p1->GetFESpace()->GetDofNrs(ElementId(VOL,elnr),dnums_lset_p1);
-      FlatVector<> lset_vals_p1(dnums_lset_p1.Size(),lh);
-      gf_lset_p1->GetVector().GetIndirect(dnums_lset_p1,lset_vals_p1);
-
-      if (ElementInRelevantBand(lset_vals_p1, lower_lset_bound, upper_lset_bound))
-        Ng_SetRefinementFlag (elnr+1, 1);
-      else
-        Ng_SetRefinementFlag (elnr+1, 0);
-    }
-      
+      Ng_SetRefinementFlag (elnr+1, marked->Test(elnr) ? 1 : 0);
+
+    return marked;
   }
 
 }
-
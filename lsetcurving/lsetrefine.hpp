@@ -14,6 +14,10 @@ using namespace ngfem;
 namespace ngcomp
 { 
 
-  void RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, LocalHeap & lh);
+  /// BitArray of all elements where the P1 level set has values in [lower_lset_bound,upper_lset_bound]
+  shared_ptr<BitArray> MarkAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound);
+
+  /// marks elements as MarkAtLevelSet and (unless mark_only) transfers the marks to the refinement flags of the mesh
+  shared_ptr<BitArray> RefineAtLevelSet (shared_ptr<GridFunction> gf_lset_p1, double lower_lset_bound, double upper_lset_bound, LocalHeap & lh, bool mark_only = false);
   
 }
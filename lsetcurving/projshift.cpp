@@ -1,6 +1,8 @@
 #include "projshift.hpp"
 #include "calcpointshift.hpp"
 #include "shiftintegrators.hpp"
+#include <map>
+#include <tuple>
 
 namespace ngcomp
 {
@@ -10,7 +12,8 @@ namespace ngcomp
                      shared_ptr<BitArray> ba,
                      shared_ptr<CoefficientFunction> blending,
                      double lower_lset_bound, double upper_lset_bound, double threshold,
-                     LocalHeap & clh)
+                     LocalHeap & clh,
+                     shared_ptr<BaseVector> lset_p1_old, double update_tol)
   {
     static Timer time_fct ("LsetCurv::ProjectShift");
     RegionTimer reg (time_fct);
@@ -42,41 +45,164 @@ namespace ngcomp
     else
       shift3D = make_shared<ShiftIntegrator<3>>(shift_array);
 
-    shared_ptr<BaseVector> factor = deform->GetVector().CreateVector();
-    *factor = 0.0;
-    deform->GetVector() = 0.0;
+    auto fes_deform = deform->GetFESpace();
+    const int ndof_deform = fes_deform->GetNDof();
+
+    // incremental update: only elements whose P1 level set values changed
+    // (more than update_tol) or which entered or left the band are recomputed
+    const bool incremental = lset_p1_old && !ba
+      && lset_p1_old->Size() == lset_p1->GetVector().Size()
+      && deform->GetVector().Size() == ndof_deform;
+
+    // first pass: elements in the band and number of band elements per dof,
+    // s.t. the averaging can be done directly in the accumulation. Dofs of
+    // changed elements are marked as "touched".
+    BitArray band(ne);
+    band.Clear();
+    BitArray touched(ndof_deform);
+    if (incremental)
+      touched.Clear();
+    else
+      touched.Set();
+    Array<int> dof_count(ndof_deform);
+    dof_count = 0;
+    ParallelForRange (Range(ne), [&](IntRange r)
+    {
+      Array<int> dnums;
+      for (int elnr : r)
+      {
+        ElementId ei(VOL,elnr);
+        bool in_band, changed = false;
+        if (ba)
+          in_band = ba->Test(elnr);
+        else
+        {
+          lset_p1->GetFESpace()->GetDofNrs(ei,dnums);
+          Vector<> vals(dnums.Size());
+          lset_p1->GetVector().GetIndirect(dnums,vals);
+          in_band = ElementInRelevantBand(vals, lower_lset_bound, upper_lset_bound);
+          if (incremental)
+          {
+            Vector<> vals_old(dnums.Size());
+            lset_p1_old->GetIndirect(dnums,vals_old);
+            const bool was_in_band = ElementInRelevantBand(vals_old, lower_lset_bound, upper_lset_bound);
+            changed = (in_band != was_in_band)
+              || (in_band && MaxNorm(vals - vals_old) > update_tol);
+          }
+        }
+        if (!in_band && !changed)
+          continue;
+        fes_deform->GetDofNrs(ei,dnums);
+        if (in_band)
+        {
+          band.SetBitAtomic(elnr);
+          for (int dof : dnums)
+            if (dof >= 0)
+              AsAtomic(dof_count[dof])++;
+        }
+        if (changed)
+          for (int dof : dnums)
+            if (dof >= 0)
+              touched.SetBitAtomic(dof);
+      }
+    });
+
+    // the previous deformation is the initial guess of the point searches,
+    // touched dofs are recomputed from scratch
+    shared_ptr<BaseVector> deform_old;
+    if (incremental)
+    {
+      deform_old = deform->GetVector().CreateVector();
+      *deform_old = deform->GetVector();
+      FlatVector<> def_vec = deform->GetVector().FVDouble();
+      ParallelForRange (Range(ndof_deform), [&](IntRange r)
+      {
+        for (int dof : r)
+          if (touched.Test(dof))
+            def_vec.Range(D*dof, D*(dof+1)) = 0.0;
+      });
+    }
+    else
+      deform->GetVector() = 0.0;
+
+    // inverse mass matrices of affine elements are the inverse reference
+    // mass matrix divided by the determinant. The reference matrix only
+    // depends on element type, order and the orientation (vertex ordering),
+    // it is computed once per thread and key.
+    struct MassKey
+    {
+      int et, order, ndof, orientation;
+      bool operator< (const MassKey & other) const
+      {
+        return std::tie(et,order,ndof,orientation)
+          < std::tie(other.et,other.order,other.ndof,other.orientation);
+      }
+    };
+    Array<std::map<MassKey,Matrix<>>> ref_inv_mass(TaskManager::GetMaxThreads());
 
     ProgressOutput progress (ma, "project shift on element", ma->GetNE());
 
+    // colored iteration, elements of one color do not share dofs
     IterateElements
-      (*(deform->GetFESpace()), VOL, clh,  [&] (FESpace::Element el, LocalHeap & lh)
+      (*fes_deform, VOL, clh,  [&] (FESpace::Element el, LocalHeap & lh)
        {
          int elnr = el.Nr();
          HeapReset hr(lh);
          progress.Update();
-      
-         Array<int> p1_dofs;
-         lset_p1->GetFESpace()->GetDofNrs(el,p1_dofs);
-         FlatVector<> vals(p1_dofs.Size(),lh);
-         lset_p1->GetVector().GetIndirect(p1_dofs,vals);
-         const ElementTransformation & eltrans = el.GetTrafo();
-      
-         if ( (ba) && ( !(ba->Test(elnr)) ))
-           return;
-         if ( (!ba) && !ElementInRelevantBand(vals, lower_lset_bound, upper_lset_bound) )
+
+         if (!band.Test(elnr))
            return;
+         auto dofs = el.GetDofs();
+         if (incremental)
+         {
+           bool has_touched = false;
+           for (int dof : dofs)
+             if (dof >= 0 && touched.Test(dof))
+               has_touched = true;
+           if (!has_touched)
+             return;
+         }
 
+         const ElementTransformation & eltrans = el.GetTrafo();
          int ndofs = el.GetDofs().Size();
          const FiniteElement & fel_deform = el.GetFE();
-         // FlatVector<> vals(def_dofs.Size(),lh);
-         // lset_p1->GetVector().GetIndirect(def_dofs,vals);
          FlatMatrix<> massmat (ndofs,lh);
          FlatVector<> elvec (D*ndofs,lh);
          FlatVector<> elres (D*ndofs,lh);
-         mass->CalcElementMatrix(fel_deform, eltrans, massmat, lh);
-         CalcInverse(massmat);
+         FlatVector<> init_deform (incremental ? D*ndofs : 0,lh);
+         if (incremental)
+           deform_old->GetIndirect(dofs,init_deform);
+
+         if (eltrans.IsCurvedElement())
+         {
+           mass->CalcElementMatrix(fel_deform, eltrans, massmat, lh);
+           CalcInverse(massmat);
+         }
+         else
+         {
+           auto verts = el.Vertices();
+           int orientation = 0;
+           for (int i = 0; i < verts.Size(); i++)
+             for (int j = i+1; j < verts.Size(); j++)
+               orientation = 2*orientation + (verts[i] < verts[j] ? 1 : 0);
+           MassKey key { int(eltrans.GetElementType()), fel_deform.Order(), ndofs, orientation };
+
+           IntegrationPoint ip_center(0.0, 0.0, 0.0, 0.0);
+           const double det = eltrans(ip_center,lh).GetMeasure();
+           auto & cache = ref_inv_mass[TaskManager::GetThreadId()];
+           auto it = cache.find(key);
+           if (it == cache.end())
+           {
+             mass->CalcElementMatrix(fel_deform, eltrans, massmat, lh);
+             CalcInverse(massmat);
+             Matrix<> & ref_inv = cache[key];
+             ref_inv.SetSize(ndofs,ndofs);
+             ref_inv = det * massmat;
+           }
+           else
+             massmat = 1.0/det * it->second;
+         }
 
-      
          Array<int> lset_ho_dofs;
          lset_ho->GetFESpace()->GetDofNrs(el,lset_ho_dofs);
          FlatVector<> lset_ho_vals(lset_ho_dofs.Size(),lh);
@@ -87,7 +213,7 @@ namespace ngcomp
          {
            const ScalarFiniteElement<2> & scafe_lset_ho = dynamic_cast< const ScalarFiniteElement<2> &>(fel_lset_ho);
            shared_ptr<LsetEvaluator<2>> lseteval = make_shared<LsetEvaluator<2>>(scafe_lset_ho,lset_ho_vals);
-           shift2D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval);
+           shift2D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval, init_deform);
         
            FlatMatrixFixWidth<2> elvec_vec(ndofs,&elvec(0));
            FlatMatrixFixWidth<2> shift_vec(ndofs,&elres(0));
@@ -102,7 +228,7 @@ namespace ngcomp
            const ScalarFiniteElement<3> & scafe_lset_ho = dynamic_cast< const ScalarFiniteElement<3> &>(fel_lset_ho);
            shared_ptr<LsetEvaluator<3>> lseteval = make_shared<LsetEvaluator<3>>(scafe_lset_ho,lset_ho_vals);
         
-           shift3D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval);
+           shift3D->CalcElementVector(fel_deform, eltrans, elvec, lh, lseteval, init_deform);
         
            FlatMatrixFixWidth<3> elvec_vec(ndofs,&elvec(0));
            FlatMatrixFixWidth<3> shift_vec(ndofs,&elres(0));
@@ -113,63 +239,20 @@ namespace ngcomp
              shift_vec.Row(l) = 0.0;
          }
 
+         // averaging over all band elements of a dof (only recomputed dofs)
+         for (int k = 0; k < ndofs; k++)
+           if (dofs[k] >= 0 && touched.Test(dofs[k]))
+             elres.Range(D*k,D*(k+1)) *= 1.0/dof_count[dofs[k]];
+           else
+             elres.Range(D*k,D*(k+1)) = 0.0;
+
          FlatVector<> def_vals(D*ndofs,lh);
-         deform->GetVector().GetIndirect(el.GetDofs(),def_vals);
+         deform->GetVector().GetIndirect(dofs,def_vals);
          def_vals += elres;
-         deform->GetVector().SetIndirect(el.GetDofs(),def_vals);
-
-         // increase dof counter
-         FlatVector<> factors(D*ndofs,lh);
-         factor->GetIndirect(el.GetDofs(),factors);
-         for (int k = 0; k < factors.Size(); k+=D)
-           factors(k) += 1.0 ;
-         factor->SetIndirect(el.GetDofs(),factors);
-
-         
+         deform->GetVector().SetIndirect(dofs,def_vals);
        });
     
     progress.Done();
-    
-    if (task_manager)
-    {
-      SharedLoop sl (Range (factor->Size()));
-      task_manager->CreateJob
-        ( [&] (const TaskInfo & ti) {
-          LocalHeap lh = clh.Split();
-          
-          // averaging of the (summed) deformation
-          Array<int> dnums(1);
-
-          for (int i : sl)
-          {
-            HeapReset hr(lh);
-            FlatVector<> val_fac(D,lh);
-            FlatVector<> values(D,lh);
-            dnums[0] = i;
-            deform->GetVector().GetIndirect(dnums,values);
-            factor->GetIndirect(dnums,val_fac);
-            if (val_fac(0) > 0)
-              values *= 1.0/val_fac(0);
-            deform->GetVector().SetIndirect(dnums,values);
-          }
-        });
-    }
-    else
-    {
-      Array<int> dnums(1);
-      for (int i : Range(factor->Size()) )
-      {
-        HeapReset hr(clh);
-        FlatVector<> val_fac(D,clh);
-        FlatVector<> values(D,clh);
-        dnums[0] = i;
-        deform->GetVector().GetIndirect(dnums,values);
-        factor->GetIndirect(dnums,val_fac);
-        if (val_fac(0) > 0)
-              values *= 1.0/val_fac(0);
-        deform->GetVector().SetIndirect(dnums,values);
-      }
-    }
   }
   
 }
@@ -15,6 +15,8 @@ namespace ngcomp
                      shared_ptr<BitArray> ba,
                      shared_ptr<CoefficientFunction> blending,
                      double lower_lset_bound, double upper_lset_bound, double threshold,
-                     LocalHeap & lh);
+                     LocalHeap & lh,
+                     // incremental update w.r.t. the P1 level set of the last call:
+                     shared_ptr<BaseVector> lset_p1_old = nullptr, double update_tol = 0.0);
 
 }
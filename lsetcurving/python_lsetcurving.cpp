@@ -9,9 +9,18 @@
 #include "../lsetcurving/lsetrefine.hpp"
 #include "../lsetcurving/projshift.hpp"
 #include "../lsetcurving/shiftedevaluate.hpp"
+#include "../xfem/cutinfo.hpp"
 
 using namespace ngcomp;
 
+py::list StatisticsToList (const Array<double> & values)
+{
+  py::list res;
+  for (double v : values)
+    res.append(v);
+  return res;
+}
+
 void ExportNgsx_lsetcurving(py::module &m)
 {
   typedef shared_ptr<FESpace> PyFES;
@@ -19,6 +28,7 @@ void ExportNgsx_lsetcurving(py::module &m)
   typedef GridFunction GF;
   typedef shared_ptr<GF> PyGF;
   typedef shared_ptr<BitArray> PyBA;
+  typedef shared_ptr<CutInformation> PyCI;
 
 
 
@@ -44,19 +54,27 @@ void ExportNgsx_lsetcurving(py::module &m)
          },
          py::arg("label")="something",py::arg("select")="all"
       )
+    .def_property_readonly("ErrorL2Norm", [](StatisticContainer & self) { return StatisticsToList(self.ErrorL2Norm); })
+    .def_property_readonly("ErrorL1Norm", [](StatisticContainer & self) { return StatisticsToList(self.ErrorL1Norm); })
+    .def_property_readonly("ErrorMaxNorm", [](StatisticContainer & self) { return StatisticsToList(self.ErrorMaxNorm); })
+    .def_property_readonly("ErrorMisc", [](StatisticContainer & self) { return StatisticsToList(self.ErrorMisc); })
     ;
 
-  m.def("CalcMaxDistance",  [] (PyCF lset_ho, PyGF lset_p1, PyGF deform, int heapsize)
+  m.def("CalcMaxDistance",  [] (PyCF lset_ho, PyGF lset_p1, PyGF deform, int heapsize, py::object acutinfo)
         {
+          shared_ptr<CutInformation> cutinfo = nullptr;
+          if (py::extract<PyCI> (acutinfo).check())
+            cutinfo = py::extract<PyCI>(acutinfo)();
           StatisticContainer dummy;
-          LocalHeap lh (heapsize, "CalcDistance-Heap");
+          LocalHeap lh (heapsize, "CalcDistance-Heap", true);
           if (lset_p1->GetMeshAccess()->GetDimension()==2)
-            CalcDistances<2>(lset_ho, lset_p1, deform,  dummy, lh, -1.0, false);
+            CalcDistances<2>(lset_ho, lset_p1, deform,  dummy, lh, -1.0, false, cutinfo);
           else
-            CalcDistances<3>(lset_ho, lset_p1, deform,  dummy, lh, -1.0, false);
+            CalcDistances<3>(lset_ho, lset_p1, deform,  dummy, lh, -1.0, false, cutinfo);
           return (double) dummy.ErrorMaxNorm[dummy.ErrorMaxNorm.Size()-1];
         } ,
         py::arg("lset_ho")=NULL,py::arg("lset_p1")=NULL,py::arg("deform")=NULL,py::arg("heapsize")=1000000,
+        py::arg("cutinfo")=DummyArgument(),
         docu_string(R"raw_string(
 Compute approximated distance between of the isoparametrically obtained geometry.
 
@@ -77,6 +95,8 @@ where
   Psi = Id + deform
 
 The approximation is obtained as the maximum that is only computed on the integration points.
+deform is applied per element to the undeformed mesh, a deformation that is set on the mesh
+is ignored (and restored afterwards).
 
 Parameters
 
@@ -91,48 +111,72 @@ deform : ngsolve.GridFunction
 
 heapsize : int
   heapsize of local computations.
+
+cutinfo : xfem.CutInfo
+  (optional) CutInfo that has been updated with lset_p1. Only its cut elements
+  are visited. Without it, all elements are checked for a sign change of lset_p1.
 )raw_string")
     )
     ;
 
   
-  m.def("CalcDistances",  [] (PyCF lset_ho, PyGF lset_p1, PyGF deform, StatisticContainer & stats, int heapsize, double refine_threshold, bool absolute)
+  m.def("CalcDistances",  [] (PyCF lset_ho, PyGF lset_p1, PyGF deform, StatisticContainer & stats, int heapsize, double refine_threshold, bool absolute, py::object acutinfo)
         {
-          LocalHeap lh (heapsize, "CalcDistance-Heap");
+          shared_ptr<CutInformation> cutinfo = nullptr;
+          if (py::extract<PyCI> (acutinfo).check())
+            cutinfo = py::extract<PyCI>(acutinfo)();
+          LocalHeap lh (heapsize, "CalcDistance-Heap", true);
           if (lset_p1->GetMeshAccess()->GetDimension()==2)
-            CalcDistances<2>(lset_ho, lset_p1, deform,  stats, lh, refine_threshold, absolute);
+            CalcDistances<2>(lset_ho, lset_p1, deform,  stats, lh, refine_threshold, absolute, cutinfo);
           else
-            CalcDistances<3>(lset_ho, lset_p1, deform,  stats, lh, refine_threshold, absolute);
+            CalcDistances<3>(lset_ho, lset_p1, deform,  stats, lh, refine_threshold, absolute, cutinfo);
         } ,
         py::arg("lset_ho")=NULL,py::arg("lset_p1")=NULL,py::arg("deform")=NULL,py::arg("stats")=NULL,py::arg("heapsize")=1000000,py::arg("refine_threshold")=-1.0,py::arg("absolute")=false,
+        py::arg("cutinfo")=DummyArgument(),
         docu_string(R"raw_string(
 This is an internal function (and should be removed after some refactoring at some point)!
 )raw_string")
     )
     ;
 
-  // m.def("CalcDeformationError",  [] (PyCF lset_ho, PyGF lset_p1, PyGF deform, PyCF qn, StatisticContainer & stats, double lower, double upper, int heapsize)
-  //       {
-  //         LocalHeap lh (heapsize, "CalcDeformationError-Heap");
-  //         if (lset_p1->GetMeshAccess()->GetDimension()==2)
-  //           CalcDeformationError<2>(lset_ho, lset_p1, deform, qn, stats, lh, lower, upper);
-  //         else
-  //           CalcDeformationError<3>(lset_ho, lset_p1, deform, qn, stats, lh, lower, upper);
-  //       } ,
-  //       py::arg("lset_ho")=NULL,py::arg("lset_p1")=NULL,py::arg("deform")=NULL,py::arg("qn")=NULL,py::arg("stats")=NULL,py::arg("lower")=0.0,py::arg("upper")=0.0,py::arg("heapsize")=1000000)
-  //   ;
+  m.def("CalcDeformationError",  [] (PyCF lset_ho, PyGF lset_p1, PyGF deform, PyCF qn, StatisticContainer & stats, double lower, double upper, int heapsize)
+        {
+          LocalHeap lh (heapsize, "CalcDeformationError-Heap", true);
+          if (lset_p1->GetMeshAccess()->GetDimension()==2)
+            CalcDeformationError<2>(lset_ho, lset_p1, deform, qn, stats, lh, lower, upper);
+          else
+            CalcDeformationError<3>(lset_ho, lset_p1, deform, qn, stats, lh, lower, upper);
+        } ,
+        py::arg("lset_ho")=NULL,py::arg("lset_p1")=NULL,py::arg("deform")=NULL,py::arg("qn")=NULL,py::arg("stats")=NULL,py::arg("lower")=0.0,py::arg("upper")=0.0,py::arg("heapsize")=1000000,
+        docu_string(R"raw_string(
+Compares deform with the shift that is obtained by a point search (w.r.t. lset_ho) on
+the integration points of the elements where lset_p1 has values in (lower,upper). The
+L2 and the maximum norm of the difference are appended to stats (ErrorL2Norm,
+ErrorMaxNorm).
+
+The point search evaluates lset_ho together with its gradient. For scalar GridFunctions
+the finite element is evaluated directly, other CoefficientFunctions are differentiated
+with difference quotients.
+)raw_string")
+    )
+    ;
 
   m.def("ProjectShift",  [] (PyGF lset_ho, PyGF lset_p1, PyGF deform, PyCF qn,
                              py::object active_elems_in,
                              PyCF blending,
-                             double lower, double upper, double threshold, int heapsize)
+                             double lower, double upper, double threshold, int heapsize,
+                             py::object lset_p1_old_in, double update_tol)
         {
           shared_ptr<BitArray> active_elems = nullptr;
           if (py::extract<PyBA> (active_elems_in).check())
             active_elems = py::extract<PyBA>(active_elems_in)();
+          shared_ptr<BaseVector> lset_p1_old = nullptr;
+          if (py::extract<shared_ptr<BaseVector>> (lset_p1_old_in).check())
+            lset_p1_old = py::extract<shared_ptr<BaseVector>>(lset_p1_old_in)();
           
           LocalHeap lh (heapsize, "ProjectShift-Heap");
-          ProjectShift(lset_ho, lset_p1, deform, qn, active_elems, blending, lower, upper, threshold, lh);
+          ProjectShift(lset_ho, lset_p1, deform, qn, active_elems, blending, lower, upper, threshold, lh,
+                       lset_p1_old, update_tol);
         } ,
         py::arg("lset_ho")=NULL,
         py::arg("lset_p1")=NULL,
@@ -143,7 +187,9 @@ This is an internal function (and should be removed after some refactoring at so
         py::arg("lower")=0.0,
         py::arg("upper")=0.0,
         py::arg("threshold")=1.0,
-        py::arg("heapsize")=1000000),
+        py::arg("heapsize")=1000000,
+        py::arg("lset_p1_old")=DummyArgument(),
+        py::arg("update_tol")=0.0,
         docu_string(R"raw_string(
 Computes the shift between points that are on the (P1 ) approximated level set function and its
 higher order accurate version. This is only applied on elements where a level value inside
@@ -209,21 +255,61 @@ threshold: float
 
 heapsize : int
   heapsize of local computations.
+
+lset_p1_old : ngsolve.BaseVector / None
+  vector of lset_p1 of the last call (with the same deform). If given (and active_elements is None),
+  the deformation is only updated on elements where lset_p1 changed by more than update_tol or
+  which entered or left the band. The previous deformation is used as initial guess of the point
+  searches.
+
+update_tol : float
+  tolerance for the change of lset_p1 in the incremental update.
 )raw_string")
     ;
 
 // ProjectShift
 
+  m.def("PointSearchStatistics",  [] (bool reset)
+        {
+          PointSearchStatistics stats = GetPointSearchStatistics();
+          if (reset)
+            ResetPointSearchStatistics();
+          py::dict res;
+          res["searches"] = stats.searches;
+          res["iterations"] = stats.iterations;
+          res["max_iterations"] = stats.max_iterations;
+          res["failures"] = stats.failures;
+          return res;
+        } ,
+        py::arg("reset")=false,
+        docu_string(R"raw_string(
+Statistics of the (Newton) point searches of the mesh deformation (ProjectShift,
+CalcDeformationError) since the last reset. Points for which the search does not
+converge keep their initial position and are counted as failures.
+
+Parameters
+
+reset : boolean
+  reset the counters after reading them.
+
+Returns
+
+dict with the number of searches, the total and maximum number of iterations and the
+number of failures.
+)raw_string")
+    ;
 
-  m.def("RefineAtLevelSet",  [] (PyGF lset_p1, double lower, double upper, int heapsize)
+
+  m.def("RefineAtLevelSet",  [] (PyGF lset_p1, double lower, double upper, int heapsize, bool mark_only)
         {
           LocalHeap lh (heapsize, "RefineAtLevelSet-Heap");
-          RefineAtLevelSet(lset_p1, lower, upper, lh);
+          return RefineAtLevelSet(lset_p1, lower, upper, lh, mark_only);
         } ,
         py::arg("gf")=NULL,py::arg("lower")=0.0,py::arg("upper")=0.0,py::arg("heapsize")=1000000,
+        py::arg("mark_only")=false,
         docu_string(R"raw_string(
 Mark mesh for refinement on all elements where the piecewise linear level set function lset_p1 has
-values in the interval [lower,upper] (default [0,0]).
+values in the interval [lower,upper] (default [0,0]). The marking is done in parallel. 
 
 Parameters
 
@@ -238,6 +324,13 @@ upper : float
 
 heapsize : int
   heapsize of local computations.
+
+mark_only : boolean
+  only compute the marked elements, but do not set the refinement flags of the mesh.
+
+Returns
+
+BitArray of the marked elements (can be combined with other markers).
 )raw_string"));
 
   m.def("shifted_eval", [](PyGF self,
@@ -252,16 +345,12 @@ heapsize : int
           if (py::extract<PyGF> (forth_in).check())
             forth = py::extract<PyGF>(forth_in)();
 
-          shared_ptr<DifferentialOperator> diffop  = nullptr;
-          
-          if (self->GetFESpace()->GetDimension() == 1)
-            diffop = make_shared<DiffOpShiftedEval<1>> (back,forth);
-          else if (self->GetFESpace()->GetDimension() == 2)
-            diffop = make_shared<DiffOpShiftedEval<2>> (back,forth);
+          if (self->GetMeshAccess()->GetDimension() == 2)
+            return PyCF(make_shared<ShiftedEvaluateCoefficientFunction<2>> (self, back, forth));
+          else if (self->GetMeshAccess()->GetDimension() == 3)
+            return PyCF(make_shared<ShiftedEvaluateCoefficientFunction<3>> (self, back, forth));
           else
-            throw Exception("shifted_eval only for dim <= 2 so far");
-
-          return PyCF(make_shared<GridFunctionCoefficientFunction> (self, diffop));
+            throw Exception("shifted_eval only for 2D and 3D meshes");
         },
         py::arg("gf"),
         py::arg("back") = DummyArgument(),
@@ -275,13 +364,12 @@ location that is computed ( pointwise ) from:
 < = >            z = Inv(Psi_back)( Psi_forth(x) )
 < = >            s = Inv(Psi_back) o Psi_forth(x)
 
-To compute z = s(x) a fixed point iteration is used.
-
-ATTENTION: 
-==========
+To compute z = s(x) a fixed point iteration is used. All points of an integration rule are
+treated at once.
 
-If s(x) leaves the the element that the integration point x is defined on, it will *NOT* change the
-element but result in an integration point that lies outside of the physical element.
+If s(x) leaves the element that the integration point x is defined on, the element containing
+s(x) is found with a bounding box tree of the mesh (built once when the CoefficientFunction is
+created). Only if s(x) lies outside of the mesh, gf is extrapolated from the element of x.
 
 Parameters
 
@@ -293,8 +381,8 @@ forth : ngsolve.GridFunction
 
 ASSUMPTIONS: 
 ============
-- 2D mesh
-- Gridfunction of dim=1 or dim=2 (ScalarFE behind it)
+- 2D or 3D mesh (without deformation set on the mesh)
+- Gridfunction with scalar finite elements (ScalarFE behind it), arbitrary dim
 )raw_string"));
   
 }
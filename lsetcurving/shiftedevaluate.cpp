@@ -1,247 +1,323 @@
 #define FILE_SHIFTEDEVALUATE_CPP
 #include "shiftedevaluate.hpp"
-#include <diffop_impl.hpp>
 
 
 namespace ngfem
 {
 
+  template <int D>
+  ElementBoxTree<D> :: ElementBoxTree (shared_ptr<MeshAccess> ma)
+  {
+    static Timer time_fct ("ElementBoxTree::ElementBoxTree");
+    RegionTimer reg (time_fct);
+
+    const int ne = ma->GetNE();
+    elmin.SetSize(ne);
+    elmax.SetSize(ne);
+    elems.SetSize(ne);
+    ParallelForRange (Range(ne), [&](IntRange r)
+    {
+      for (int elnr : r)
+      {
+        elems[elnr] = elnr;
+        Ngs_Element ngel = ma->GetElement(ElementId(VOL,elnr));
+        elmin[elnr] = numeric_limits<double>::max();
+        elmax[elnr] = -numeric_limits<double>::max();
+        for (auto v : ngel.Vertices())
+        {
+          Vec<D> p;
+          ma->GetPoint<D>(v,p);
+          for (int d = 0; d < D; d++)
+          {
+            elmin[elnr](d) = min(elmin[elnr](d), p(d));
+            elmax[elnr](d) = max(elmax[elnr](d), p(d));
+          }
+        }
+        // curved elements can leave the box of their vertices
+        const double margin = 0.1 * L2Norm(elmax[elnr] - elmin[elnr]);
+        for (int d = 0; d < D; d++)
+        {
+          elmin[elnr](d) -= margin;
+          elmax[elnr](d) += margin;
+        }
+      }
+    });
+    if (ne > 0)
+      Build(0, ne);
+  }
 
   template <int D>
-  void DiffOpShiftedEval<D> ::
-  CalcMatrix (const FiniteElement & bfel,
-              const BaseMappedIntegrationPoint & bmip,
-              SliceMatrix<double,ColMajor> mat,
-              LocalHeap & lh) const
+  int ElementBoxTree<D> :: Build (int first, int next)
   {
-    const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
-      static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmip);
+    Node node;
+    node.first = first;
+    node.next = next;
+    node.pmin = numeric_limits<double>::max();
+    node.pmax = -numeric_limits<double>::max();
+    for (int k = first; k < next; k++)
+      for (int d = 0; d < D; d++)
+      {
+        node.pmin(d) = min(node.pmin(d), elmin[elems[k]](d));
+        node.pmax(d) = max(node.pmax(d), elmax[elems[k]](d));
+      }
+    const int nr = nodes.Size();
+    nodes.Append(node);
 
-    const ScalarFiniteElement<2> & scafe =
-            dynamic_cast<const ScalarFiniteElement<2> & > (bfel);
-    const int ndof = scafe.GetNDof();
+    constexpr int leaf_size = 8;
+    if (next - first > leaf_size)
+    {
+      // split at the median of the box centers in the direction of the largest extension
+      int dir = 0;
+      for (int d = 1; d < D; d++)
+        if (node.pmax(d) - node.pmin(d) > node.pmax(dir) - node.pmin(dir))
+          dir = d;
+      const int mid = (first + next) / 2;
+      int * data = &elems[0];
+      std::nth_element(data + first, data + mid, data + next, [&] (int a, int b)
+                       {
+                         return elmin[a](dir) + elmax[a](dir) < elmin[b](dir) + elmax[b](dir);
+                       });
+      const int child0 = Build(first, mid);
+      const int child1 = Build(mid, next);
+      nodes[nr].child[0] = child0;
+      nodes[nr].child[1] = child1;
+    }
+    return nr;
+  }
 
-    FlatVector<> shape (ndof,lh);
 
-    IntegrationPoint ip(mip.IP());
-    auto elid = mip.GetTransformation().GetElementId();
-    Array<int> dnums;
+  /// checks if ip lies in the reference element (up to eps)
+  static bool InsideReferenceElement (ELEMENT_TYPE et, const IntegrationPoint & ip, double eps)
+  {
+    const double x = ip(0), y = ip(1), z = ip(2);
+    switch (et)
+    {
+    case ET_TRIG:
+      return x >= -eps && y >= -eps && x + y <= 1 + eps;
+    case ET_QUAD:
+      return x >= -eps && y >= -eps && x <= 1 + eps && y <= 1 + eps;
+    case ET_TET:
+      return x >= -eps && y >= -eps && z >= -eps && x + y + z <= 1 + eps;
+    case ET_PRISM:
+      return x >= -eps && y >= -eps && x + y <= 1 + eps && z >= -eps && z <= 1 + eps;
+    case ET_HEX:
+      return x >= -eps && y >= -eps && z >= -eps && x <= 1 + eps && y <= 1 + eps && z <= 1 + eps;
+    default:
+      throw Exception("shifted_eval: element type not supported");
+    }
+  }
 
-    Vec<2> z = mip.GetPoint();
 
-    if (forth)
+  /// finite element and coefficients (one column per component) of a GridFunction on one
+  /// element, reloaded only if the element changes
+  template <int D>
+  class ShiftedEvalElementData
+  {
+    shared_ptr<GridFunction> gf;
+    int elnr = -1;
+    const ScalarFiniteElement<D> * fe = nullptr;
+    Matrix<> coefs;
+    Array<int> dnums;
+    LocalHeapMem<10000> lh;
+  public:
+    ShiftedEvalElementData (shared_ptr<GridFunction> agf)
+      : gf(agf), lh("ShiftedEvalElementData") { ; }
+
+    void Load (int aelnr)
     {
-      forth->GetFESpace()->GetDofNrs(elid,dnums);
-      FlatVector<> values_forth(dnums.Size()*DIM_SPACE,lh);
-      FlatMatrixFixWidth<2> vector_forth(dnums.Size(),&(values_forth(0)));
-      forth->GetVector().GetIndirect(dnums,values_forth);
-
-      FiniteElement& fe_forth = forth->GetFESpace()->GetFE(elid,lh);
-      const ScalarFiniteElement<2> & scafe_forth =
-        dynamic_cast<const ScalarFiniteElement<2> & > (fe_forth);
-      FlatVector<> shape_forth(dnums.Size(),lh);
-      scafe_forth.CalcShape(ip,shape_forth);
-      Vec<2> dvec_forth = Trans(vector_forth)*shape_forth;
-      z += dvec_forth;
+      if (aelnr == elnr)
+        return;
+      elnr = aelnr;
+      lh.CleanUp();
+      ElementId ei(VOL,elnr);
+      fe = &dynamic_cast<const ScalarFiniteElement<D> &> (gf->GetFESpace()->GetFE(ei,lh));
+      gf->GetFESpace()->GetDofNrs(ei,dnums);
+      const int dim = gf->GetFESpace()->GetDimension();
+      coefs.SetSize(dnums.Size(), dim);
+      FlatVector<> values(dnums.Size()*dim, &coefs(0,0));
+      gf->GetVector().GetIndirect(dnums,values);
     }
-      
 
-    // Solve the problem Theta(Phi(x)) = z
+    void Evaluate (const IntegrationPoint & ip, FlatVector<> res, LocalHeap & clh) const
+    {
+      HeapReset hr(clh);
+      FlatVector<> shape(fe->GetNDof(),clh);
+      fe->CalcShape(ip,shape);
+      res = Trans(coefs) * shape;
+    }
 
-    if (back)
+    /// values in all points of the rule at once
+    void Evaluate (const IntegrationRule & ir, FlatMatrix<> res, LocalHeap & clh) const
     {
-      
-      back->GetFESpace()->GetDofNrs(elid,dnums);
-      FlatVector<> values_back(dnums.Size()*DIM_SPACE,lh);
-      FlatMatrixFixWidth<2> vector_back(dnums.Size(),&(values_back(0)));
-      back->GetVector().GetIndirect(dnums,values_back);
-    
-      FiniteElement& fe_back = back->GetFESpace()->GetFE(elid,lh);
-      const ScalarFiniteElement<2> & scafe_back =
-        dynamic_cast<const ScalarFiniteElement<2> & > (fe_back);
-      FlatVector<> shape_back(dnums.Size(),lh);
-      scafe_back.CalcShape(ip,shape_back);
-      Vec<2> dvec_back = Trans(vector_back)*shape_back;
-    
-
-      int its = 0;
-      const double h = sqrt(mip.GetJacobiDet());
-      Vec<2> diff;
-      IntegrationPoint ipx(ip);
-
-      IntegrationPoint ipx0(0,0,0);
-      MappedIntegrationPoint<2,2> mip_x0(ipx0,mip.GetTransformation());
-      Vec<2> zdiff = z-mip_x0.GetPoint();
-    
-      // static atomic<int> cnt_its(0);
-      // static atomic<int> cnt_calls(0);
-      
-      // Fixed point iteration
-      while (its < 100)
-      {
-        scafe_back.CalcShape(ipx,shape_back);
-        dvec_back = Trans(vector_back)*shape_back;
-        diff = zdiff - dvec_back - mip.GetJacobian() * ipx.Point();
-        // cout << "diff = " << diff << endl;
-        // cout << "its = " << its << endl;
-        if ( L2Norm(diff) < 1e-8*h ) break;
-        ipx.Point() = mip.GetJacobianInverse() * (zdiff - dvec_back);
-
-        its++;
-        // cnt_its++;
-      
-      }
-      if (its == 50)
-        throw Exception(" shifted eval took 50 iterations and didn't (yet?) converge! ");
-    
-      // cnt_calls++;
-      // cout << "cnt/calls = " << cnt_its/cnt_calls << endl;
-
-      /* 
-         FlatMatrixFixWidth<2> dshape_back(dnums.Size(),lh);
-         FlatVector<> shape_back_new(dnums.Size(),lh);
-
-         // not so robust Newton-type version (not working so well):
-    
-         while (its==0 || (L2Norm(diff) > 1e-8*h && its < 20000))
-         {
-         MappedIntegrationPoint<2,2> mip_x0(ipx,mip.GetTransformation());
-         scafe_back.CalcShape(ipx,shape_back);
-         dvec_back = Trans(vector_back)*shape_back;
-         diff = z - dvec_back - mip_x0.GetPoint();
-         Mat<2> dphi = mip_x0.GetJacobian();
-         scafe_back.CalcDShape(ipx,dshape_back);
-         Mat<2> dback_ref = Trans(dshape_back)*vector_back;
-         Mat<2> dback = Trans(mip_x0.GetJacobianInverse())*dback_ref + dphi;
-         Mat<2> invd;
-         CalcInverse(dback,invd);
-
-         // Backtracking-Armijo line search
-
-         // scalars
-         double alpha = 1;
-         double beta = 0.1;
-         int itsb = 0;
-         // descent direction
-         Vec<2> ddirection = invd * diff;
-         // Jacobi matrix
-         Mat<2> jacobi_old = dback;
-         // function value at current Newton iterate
-         Vec<2> value_old = -diff;
-         // Stuff to calculate function value at
-         // prospective new iterate
-         IntegrationPoint ipx_new(x);
-         // the difference in the Armijo condition of which all components
-         // need to be <= 0
-         Vec<2> diffb;
-
-         while(itsb == 0 || ( ( (diffb(0) > 1e-8*h) || (diffb(1) > 1e-8*h) ) && itsb < 100) )
-         {
-         if(itsb != 0)
-         alpha *= 0.98;
-         ipx_new.Point() = x + alpha*ddirection;
-         MappedIntegrationPoint<2,2> mip_xnew(ipx_new,mip.GetTransformation());
-         scafe_back.CalcShape(ipx_new,shape_back_new);
-         Vec<2> dvec_back_new = Trans(vector_back)*shape_back_new;
-         Vec<2> value_new = -z + mip_xnew.GetPoint() + dvec_back_new;
-         diffb = value_new - value_old - alpha*beta*jacobi_old*ddirection;
-         itsb ++;
-         // cout << "itsb = " << itsb << endl;
-         // cout << "diffb(0) = " << diffb(0) << endl;
-         // cout << "diffb(1) = " << diffb(1) << endl;
-         }
-
-         cout << "alpha = " << alpha << endl;
-
-
-         its++;
-         //alpha = 0.25;
-         x += alpha*invd * diff;
-
-         // cout << "x = " << x << endl;
-         // cout << "z = " << z << endl;
-         cout << "diff = " << diff << endl;
-         cout << "its = " << its << endl;
-         // cout << "dvec_back = " << dvec_back << endl;
-         // cout << "dvec_forth = " << dvec_forth << endl;
-         // cout << "dphi = " << dphi << endl;
-         // cout << "dback_ref = " << dback_ref << endl;
-         // cout << "dback = " << dback << endl;
-         //getchar();
-
-         cnt++;
-         cout << "cnt = " << cnt << endl;
-         ipx.Point() = x;
-
-         }
-      */
-
-      scafe.CalcShape(ipx,shape);
-      mat = 0.0;
-      mat.Row(0) = shape;
+      HeapReset hr(clh);
+      FlatMatrix<> shapes(fe->GetNDof(),ir.Size(),clh);
+      fe->CalcShape(ir,shapes);
+      res = Trans(shapes) * coefs;
     }
-    else
+  };
+
+
+  template <int D>
+  ShiftedEvaluateCoefficientFunction<D> ::
+  ShiftedEvaluateCoefficientFunction (shared_ptr<GridFunction> agf,
+                                      shared_ptr<GridFunction> aback,
+                                      shared_ptr<GridFunction> aforth)
+    : CoefficientFunction(agf->GetFESpace()->GetDimension(), false),
+      gf(agf), back(aback), forth(aforth), ma(agf->GetMeshAccess()), tree(agf->GetMeshAccess())
+  {
+    if (back && back->GetFESpace()->GetDimension() != D)
+      throw Exception("shifted_eval: back has to be a vector-valued GridFunction of the mesh dimension");
+    if (forth && forth->GetFESpace()->GetDimension() != D)
+      throw Exception("shifted_eval: forth has to be a vector-valued GridFunction of the mesh dimension");
+  }
+
+  template <int D>
+  bool ShiftedEvaluateCoefficientFunction<D> ::
+  PointInElement (int elnr, const Vec<D> & p, IntegrationPoint & ip, LocalHeap & lh) const
+  {
+    HeapReset hr(lh);
+    ElementTransformation & eltrans = ma->GetTrafo(ElementId(VOL,elnr), lh);
+    const ELEMENT_TYPE et = eltrans.GetElementType();
+
+    // Newton iteration for the reference coordinates starting from the center
+    const POINT3D * refverts = ElementTopology::GetVertices(et);
+    const int nverts = ElementTopology::GetNVertices(et);
+    Vec<3> center = 0.0;
+    for (int k = 0; k < nverts; k++)
+      for (int d = 0; d < D; d++)
+        center(d) += refverts[k][d] / nverts;
+    ip = IntegrationPoint(center(0), center(1), center(2), 0.0);
+    for (int its = 0; its < 10; its++)
     {
-      int its = 0;
-      const double h = sqrt(mip.GetJacobiDet());
-      Vec<2> diff;
-      IntegrationPoint ipx(ip);
-      IntegrationPoint ipx0(0,0,0);
-      MappedIntegrationPoint<2,2> mip_x0(ipx0,mip.GetTransformation());
-      Vec<2> zdiff = z-mip_x0.GetPoint();
-    
-      // Fixed point iteration
-      while (its < 100)
-      {
-        diff = zdiff - mip.GetJacobian() * ipx.Point();
-        if ( L2Norm(diff) < 1e-8*h ) break;
-        ipx.Point() = mip.GetJacobianInverse() * zdiff;
-        its++;
-      }
-      if (its == 50)
-        throw Exception(" shifted eval took 50 iterations and didn't (yet?) converge! ");
-
-      scafe.CalcShape(ipx,shape);
-      mat = 0.0;
-      for (int j = 0; j < D; j++)
-        for (int k = 0; k < shape.Size(); k++)
-          mat(j,k*D+j) = shape(k);
+      MappedIntegrationPoint<D,D> mip(ip,eltrans);
+      Vec<D> update = mip.GetJacobianInverse() * (p - mip.GetPoint());
+      for (int d = 0; d < D; d++)
+        ip(d) += update(d);
+      if (L2Norm(update) < 1e-12)
+        break;
     }
-    
+    return InsideReferenceElement(et, ip, 1e-10);
   }
 
+  template <int D>
+  int ShiftedEvaluateCoefficientFunction<D> ::
+  LocatePoint (const Vec<D> & p, int elhint, IntegrationPoint & ip, LocalHeap & lh) const
+  {
+    if (elhint >= 0 && PointInElement(elhint, p, ip, lh))
+      return elhint;
+    return tree.Find(p, [&] (int elnr)
+                     {
+                       return elnr != elhint && PointInElement(elnr, p, ip, lh);
+                     });
+  }
 
   template <int D>
-  void DiffOpShiftedEval<D> ::
-  Apply (const FiniteElement & fel,
-         const BaseMappedIntegrationPoint & mip,
-         FlatVector<double> x, 
-         FlatVector<double> flux,
-         LocalHeap & lh) const
+  double ShiftedEvaluateCoefficientFunction<D> ::
+  Evaluate (const BaseMappedIntegrationPoint & ip) const
   {
-    HeapReset hr(lh);
-    FlatMatrix<double,ColMajor> mat(Dim(), x.Size(), lh);
-    CalcMatrix (fel, mip, mat, lh);
-    flux = mat * x;
+    if (Dimension() != 1)
+      throw Exception("ShiftedEvaluateCoefficientFunction: scalar evaluation of a vector-valued function");
+    Vec<1> res;
+    Evaluate(ip, res);
+    return res(0);
   }
-  
+
   template <int D>
-  void DiffOpShiftedEval<D> ::
-  ApplyTrans (const FiniteElement & fel,
-              const BaseMappedIntegrationPoint & mip,
-              FlatVector<double> flux,
-              FlatVector<double> x,
-              LocalHeap & lh) const
+  void ShiftedEvaluateCoefficientFunction<D> ::
+  Evaluate (const BaseMappedIntegrationPoint & ip, FlatVector<> res) const
   {
-    HeapReset hr(lh);
-    FlatMatrix<double,ColMajor> mat(Dim(), x.Size(), lh);
-    CalcMatrix (fel, mip, mat, lh);
-    x = Trans(mat) * flux;
+    LocalHeapMem<10000> lh("ShiftedEvaluateCF::Evaluate");
+    IntegrationRule ir(1, const_cast<IntegrationPoint*>(&ip.IP()));
+    auto & mir = ip.GetTransformation()(ir, lh);
+    Evaluate(mir, FlatMatrix<>(1, Dimension(), &res(0)));
   }
 
-  template class DiffOpShiftedEval<1>;
-  template class DiffOpShiftedEval<2>;
+  template <int D>
+  void ShiftedEvaluateCoefficientFunction<D> ::
+  Evaluate (const BaseMappedIntegrationRule & mir, FlatMatrix<double> values) const
+  {
+    static Timer time_fct ("ShiftedEvaluateCF::Evaluate");
+    RegionTimer reg (time_fct);
+
+    LocalHeapMem<100000> lh("ShiftedEvaluateCF::Evaluate");
+    const IntegrationRule & ir = mir.IR();
+    const int npts = ir.Size();
+    const int elnr = mir.GetTransformation().GetElementNr();
+
+    // z = Psi_forth(x) for all points of the rule
+    FlatMatrix<> z(npts, D, lh);
+    for (int i = 0; i < npts; i++)
+      z.Row(i) = mir[i].GetPoint();
+    if (forth)
+    {
+      ShiftedEvalElementData<D> forth_data(forth);
+      forth_data.Load(elnr);
+      FlatMatrix<> dforth(npts, D, lh);
+      forth_data.Evaluate(ir, dforth, lh);
+      z += dforth;
+    }
 
-}
+    // initial guess for y with Psi_back(y) = z: y = z - back(x)
+    ShiftedEvalElementData<D> back_data(back);
+    FlatMatrix<> dback(npts, D, lh);
+    dback = 0.0;
+    if (back)
+    {
+      back_data.Load(elnr);
+      back_data.Evaluate(ir, dback, lh);
+    }
 
+    // element containing p, if p is outside of the mesh the element of the
+    // hint is used with the extrapolated reference coordinates
+    auto locate = [&] (const Vec<D> & p, int elhint, IntegrationPoint & ipy)
+    {
+      const int found = LocatePoint(p, elhint, ipy, lh);
+      if (found != -1)
+        return found;
+      PointInElement(elhint, p, ipy, lh);
+      return elhint;
+    };
+
+    ShiftedEvalElementData<D> gf_data(gf);
+    Vec<D> y, dvec;
+    for (int i = 0; i < npts; i++)
+    {
+      for (int d = 0; d < D; d++)
+        y(d) = z(i,d) - dback(i,d);
+      int el = elnr;
+      IntegrationPoint ipy(ir[i]);
 
+      if (back)
+      {
+        // fixed point iteration y = z - back(y), back evaluated in the element containing y
+        const double h = pow(mir[i].GetMeasure(), 1.0/D);
+        int its = 0;
+        for ( ; its < 100; its++)
+        {
+          el = locate(y, el, ipy);
+          back_data.Load(el);
+          back_data.Evaluate(ipy, dvec, lh);
+          Vec<D> ynew;
+          for (int d = 0; d < D; d++)
+            ynew(d) = z(i,d) - dvec(d);
+          const double diff = L2Norm(ynew - y);
+          y = ynew;
+          if (diff < 1e-8*h)
+            break;
+        }
+        if (its == 100)
+          throw Exception(" shifted eval took 100 iterations and didn't (yet?) converge! ");
+      }
+
+      el = locate(y, el, ipy);
+      gf_data.Load(el);
+      gf_data.Evaluate(ipy, values.Row(i), lh);
+    }
+  }
+
+  template class ElementBoxTree<2>;
+  template class ElementBoxTree<3>;
+  template class ShiftedEvaluateCoefficientFunction<2>;
+  template class ShiftedEvaluateCoefficientFunction<3>;
+
+}
@@ -9,65 +9,94 @@ using namespace ngcomp;
 namespace ngfem
 {
 
+  /// bounding box tree over the (undeformed) volume elements of a mesh
   template <int D>
-  class DiffOpShiftedEval : public DifferentialOperator
+  class ElementBoxTree
   {
+    struct Node
+    {
+      Vec<D> pmin, pmax;
+      int first, next;           // range of the elements of the node in elems
+      int child[2] = {-1, -1};   // leaf if no children
+    };
+    Array<Node> nodes;
+    Array<int> elems;
+    Array<Vec<D>> elmin, elmax;
 
+    int Build (int first, int next);
 
-  public:
-
-    shared_ptr<GridFunction> back;
-    shared_ptr<GridFunction> forth;
+    static bool Contains (const Vec<D> & pmin, const Vec<D> & pmax, const Vec<D> & p)
+    {
+      for (int d = 0; d < D; d++)
+        if (p(d) < pmin(d) || p(d) > pmax(d))
+          return false;
+      return true;
+    }
 
-    enum { DIM = D };          // D copies of the spaces
-    enum { DIM_SPACE = 2 };    // D-dim space
-    enum { DIM_ELEMENT = 2 };  // D-dim elements (in contrast to boundary elements)
-    enum { DIM_DMAT = D };     // D-matrix
-    enum { DIFFORDER = 0 };    // minimal differential order (to determine integration order)
+  public:
+    ElementBoxTree (shared_ptr<MeshAccess> ma);
 
-    DiffOpShiftedEval(shared_ptr<GridFunction> aback,shared_ptr<GridFunction> aforth)
-      : DifferentialOperator(DIM_DMAT, 1, VorB(int(DIM_SPACE)-int(DIM_ELEMENT)), DIFFORDER),
-        back(aback), forth(aforth)
+    /// calls func(elnr) for the elements with a box containing p until func returns true.
+    /// Returns that element or -1 if there is none.
+    template <typename FUNC>
+    int Find (const Vec<D> & p, FUNC func) const
     {
-      //dimensions = DIFFOP::GetDimensions();
-      dimensions = Array<int> ( { DIM_DMAT } );
-
+      if (nodes.Size() == 0)
+        return -1;
+      ArrayMem<int,64> stack;
+      stack.Append(0);
+      while (stack.Size() > 0)
+      {
+        const Node & node = nodes[stack.Last()];
+        stack.DeleteLast();
+        if (!Contains(node.pmin, node.pmax, p))
+          continue;
+        if (node.child[0] == -1)
+        {
+          for (int k = node.first; k < node.next; k++)
+          {
+            const int elnr = elems[k];
+            if (Contains(elmin[elnr], elmax[elnr], p) && func(elnr))
+              return elnr;
+          }
+        }
+        else
+        {
+          stack.Append(node.child[0]);
+          stack.Append(node.child[1]);
+        }
+      }
+      return -1;
     }
-    /*
-    virtual int Dim() const { return DIM_DMAT; }
-    virtual bool Boundary() const { return int(DIM_SPACE) > int(DIM_ELEMENT); }
-    virtual int DiffOrder() const { return DIFFORDER; }
-    */
-    virtual string Name() const { return "Fix_time"; }
-
-    virtual bool operator== (const DifferentialOperator & diffop2) const
-    { return typeid(*this) == typeid(diffop2); }
+  };
 
+  /// Evaluates a GridFunction gf at a shifted location s(x) = Inv(Psi_back)(Psi_forth(x)) with
+  /// Psi_back = I + back, Psi_forth = I + forth. s(x) may lie in a different element than x, the
+  /// element is located with a bounding box tree of the mesh.
+  template <int D>
+  class ShiftedEvaluateCoefficientFunction : public CoefficientFunction
+  {
+    shared_ptr<GridFunction> gf;
+    shared_ptr<GridFunction> back;
+    shared_ptr<GridFunction> forth;
+    shared_ptr<MeshAccess> ma;
+    ElementBoxTree<D> tree;
 
-    virtual void
-    CalcMatrix (const FiniteElement & bfel,
-        const BaseMappedIntegrationPoint & bmip,
-        SliceMatrix<double,ColMajor> mat,
-        LocalHeap & lh) const;
+  public:
+    ShiftedEvaluateCoefficientFunction (shared_ptr<GridFunction> agf,
+                                        shared_ptr<GridFunction> aback,
+                                        shared_ptr<GridFunction> aforth);
 
+    virtual double Evaluate (const BaseMappedIntegrationPoint & ip) const;
+    virtual void Evaluate (const BaseMappedIntegrationPoint & ip, FlatVector<> res) const;
+    virtual void Evaluate (const BaseMappedIntegrationRule & ir, FlatMatrix<double> values) const;
 
-    virtual void
-    Apply (const FiniteElement & fel,
-           const BaseMappedIntegrationPoint & mip,
-           FlatVector<double> x, 
-           FlatVector<double> flux,
-           LocalHeap & lh) const;
-    
-    virtual void
-    ApplyTrans (const FiniteElement & fel,
-        const BaseMappedIntegrationPoint & mip,
-        FlatVector<double> flux,
-        FlatVector<double> x,
-        LocalHeap & lh) const;
+    /// reference coordinates ip of the point p w.r.t. element elnr, true if p is inside
+    bool PointInElement (int elnr, const Vec<D> & p, IntegrationPoint & ip, LocalHeap & lh) const;
 
+    /// element that contains p (elhint is tried first), -1 if p is outside of the mesh
+    int LocatePoint (const Vec<D> & p, int elhint, IntegrationPoint & ip, LocalHeap & lh) const;
   };
 
-
-
 }
 #endif
@@ -40,7 +40,8 @@ namespace ngfem
                                                 const ElementTransformation & eltrans,
                                                 FlatVector<double> elvec,
                                                 LocalHeap & lh,
-                                                shared_ptr<LsetEvaluator<D>> lseteval) const
+                                                shared_ptr<LsetEvaluator<D>> lseteval,
+                                                FlatVector<double> init_deform) const
   {
     static Timer time_fct ("ShiftIntegrator<D>::CalcElementVector");
     RegionTimer reg (time_fct);
@@ -49,13 +50,11 @@ namespace ngfem
     const ScalarFiniteElement<D> & scafe = dynamic_cast<const ScalarFiniteElement<D> &>(fel);
 
     if (!lseteval)
-      lseteval = make_shared<LsetEvaluator<D>>(coef_lset_ho, eltrans);
+      lseteval = make_shared<LsetEvaluator<D>>(MakeLsetEvaluator<D>(coef_lset_ho, eltrans, lh));
     
     FlatMatrixFixWidth<D> elvecmat(scafe.GetNDof(),&elvec(0));
     elvecmat = 0.0;
     
-    FlatVector<> shape (scafe.GetNDof(),lh);
-      
     Vec<D> grad;
     if (!qn) //grad is constant on element...
     {
@@ -65,59 +64,112 @@ namespace ngfem
     }
     
     IntegrationRule ir = SelectIntegrationRule (eltrans.GetElementType(), 2*scafe.Order());
-    for (int l = 0 ; l < ir.GetNIP(); l++)
+    const int nip = ir.GetNIP();
+    MappedIntegrationRule<D,D> mir(ir, eltrans, lh);
+    // the same points as SIMD rule for the evaluation of (previous) deformations
+    // and the right hand side, lanes beyond nip are padding
+    constexpr int W = SIMD<double>::Size();
+    SIMD_IntegrationRule simd_ir(ir, lh);
+    const int nsimd = simd_ir.Size();
+
+    // coefficients on all points of the rule at once
+    FlatMatrix<> lsetp1vals(nip, 1, lh);
+    coef_lset_p1->Evaluate(mir, lsetp1vals);
+    FlatMatrix<> qnvals(qn ? nip : 0, D, lh);
+    if (qn)
+      qn->Evaluate(mir, qnvals);
+    FlatMatrix<> alphas(nip, 1, lh);
+    alphas = 0.0; // blending factor, 0.0 means: find phi_lin, 1.0 means: find phi (i.e. goal value = start value)
+    if (coef_blending)
+      coef_blending->Evaluate(mir, alphas);
+
+    // setup of all point searches of the element, the Jacobians of the
+    // mapped rule are only set up once per element
+    FlatMatrixFixWidth<D> orig_points(nip, lh);
+    FlatMatrixFixWidth<D> normals(nip, lh);
+    FlatMatrixFixWidth<D> final_points(nip, lh);
+    FlatVector<> goal_vals(nip, lh);
+    FlatArray<Mat<D>> trafo_of_normals(nip, lh);
+    for (int l = 0 ; l < nip; l++)
     {
-      MappedIntegrationPoint<D,D> mip(ir[l], eltrans);
-      scafe.CalcShape(ir[l],shape);
+      const MappedIntegrationPoint<D,D> & mip = mir[l];
+      const Mat<D> jacinv = mip.GetJacobianInverse();
 
-      Mat<D> trafo_of_normals = mip.GetJacobianInverse() * Trans(mip.GetJacobianInverse());
+      trafo_of_normals[l] = jacinv * Trans(jacinv);
         
       if (qn)
-        qn->Evaluate(mip,grad);
+        grad = qnvals.Row(l);
 
-      Vec<D> normal = mip.GetJacobianInverse() * grad;
-      // double len = L2Norm(normal);
-      // normal /= len;
+      normals.Row(l) = jacinv * grad;
         
-      Vec<D> orig_point;
       for (int d = 0; d < D; ++d)
-        orig_point(d) = ir[l](d);
-
-      const double lsetp1val = coef_lset_p1->Evaluate(mip);
-                                                                                 
-      // const double h = D == 2 ? sqrt(2) * sqrt(mip.GetMeasure()) : sqrt(3) * cbrt(mip.GetMeasure());
-      // double alpha = abs(lsetp1val / h) * abs(lsetp1val / h);
-
-      double alpha = 0.0; // blending factor, 0.0 means: find phi_lin, 1.0 means: find phi (i.e. goal value = start value)
-      if (coef_blending)
-        alpha = coef_blending->Evaluate(mip);
+        orig_points(l,d) = ir[l](d);
 
+      const double alpha = alphas(l,0);
       if (alpha > 1)
         throw Exception("alpha should not be larger than 1");
       
-      double goal_val = (1.0-alpha) * lsetp1val + alpha * lseteval->Evaluate(mip.IP(),lh);
+      goal_vals(l) = (1.0-alpha) * lsetp1vals(l,0);
+      // the high order level set only enters with alpha != 0 (value only)
+      if (alpha != 0.0)
+        goal_vals(l) += alpha * lseteval->Evaluate(ir[l], lh);
+    }
 
-      // double goal_val = coef_lset_p1->Evaluate(mip);
-      
-      Vec<D> final_point;
-      SearchCorrespondingPoint<D>(*lseteval,
-                                  orig_point, goal_val, 
-                                  trafo_of_normals, normal, false,
-                                  final_point, lh);
-      Vec<D> ref_dist = (final_point - orig_point);
+    FlatMatrix<> lanes(D, nsimd*W, lh);
+    FlatVector<SIMD<double>> simd_vals(nsimd, lh);
+
+    // start the searches at the previous shift (projected on the search direction)
+    FlatMatrixFixWidth<D> start_points(init_deform.Size() > 0 ? nip : 0, lh);
+    if (init_deform.Size() > 0)
+    {
+      FlatMatrixFixWidth<D> prev_deform(scafe.GetNDof(), &init_deform(0));
+      for (int d = 0; d < D; d++)
+      {
+        scafe.Evaluate(simd_ir, prev_deform.Col(d), simd_vals);
+        for (int k = 0; k < nsimd; k++)
+          for (int j = 0; j < W; j++)
+            lanes(d, k*W+j) = simd_vals(k)[j];
+      }
+      for (int l = 0 ; l < nip; l++)
+      {
+        Vec<D> prev_def = lanes.Col(l);
+        Vec<D> prev_ref_dist = mir[l].GetJacobianInverse() * prev_def;
+        Vec<D> normal = normals.Row(l);
+        const double nn = InnerProduct(normal,normal);
+        start_points.Row(l) = orig_points.Row(l);
+        if (nn > 0)
+          start_points.Row(l) += InnerProduct(prev_ref_dist,normal) / nn * normal;
+      }
+    }
+
+    SearchCorrespondingPoints<D>(*lseteval,
+                                 orig_points, goal_vals,
+                                 trafo_of_normals, normals, false,
+                                 final_points, lh, nullptr, start_points);
+
+    // weighted deformations in all points, L2 projection right hand side with
+    // the SIMD rule
+    lanes = 0.0;
+    for (int l = 0 ; l < nip; l++)
+    {
+      const MappedIntegrationPoint<D,D> & mip = mir[l];
+
+      Vec<D> ref_dist = final_points.Row(l) - orig_points.Row(l);
       const double ref_dist_size = L2Norm(ref_dist);
       if ((max_deform >= 0.0) && (ref_dist_size > max_deform))
       {
         ref_dist *= max_deform / ref_dist_size; 
       }
 
-        
       Vec<D> deform = mip.GetJacobian() * ref_dist;
-      // if (qn)
-      //   deform = InnerProduct(deform,qnormal) * qnormal;
-
-      elvecmat += mip.GetWeight() * shape * Trans(deform);
-    }      
+      lanes.Col(l) = mip.GetWeight() * deform;
+    }
+    for (int d = 0; d < D; d++)
+    {
+      for (int k = 0; k < nsimd; k++)
+        simd_vals(k) = SIMD<double>(&lanes(d, k*W));
+      scafe.AddTrans(simd_ir, simd_vals, elvecmat.Col(d));
+    }
   }
 
 
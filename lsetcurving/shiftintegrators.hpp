@@ -26,11 +26,22 @@ namespace ngfem
     virtual int DimSpace () const { return D; }
     // virtual bool BoundaryForm () const { return false; }
     virtual VorB VB () const { return VOL; }
+    /// init_deform: coefficients of a previous deformation on the element
+    /// (initial guess of the point searches), empty: no initial guess
+    void CalcElementVector (const FiniteElement & fel,
+                            const ElementTransformation & eltrans,
+                            FlatVector<double> elvec,
+                            LocalHeap & lh,
+                            shared_ptr<LsetEvaluator<D>> lseteval,
+                            FlatVector<double> init_deform) const;
     virtual void CalcElementVector (const FiniteElement & fel,
                                     const ElementTransformation & eltrans,
                                     FlatVector<double> elvec,
                                     LocalHeap & lh,
-                                    shared_ptr<LsetEvaluator<D>> lseteval) const;
+                                    shared_ptr<LsetEvaluator<D>> lseteval) const
+    {
+      CalcElementVector(fel,eltrans,elvec,lh,lseteval,FlatVector<double>(0,(double*)nullptr));
+    }
     virtual void CalcElementVector (const FiniteElement & fel,
                                     const ElementTransformation & eltrans,
                                     FlatVector<double> elvec,
@@ -402,7 +402,7 @@ def SolveProblem(sd, delta_t ):
         # the Dofs belonging to these elements.
         for t_i in sd.points_time_ref:
             t.Set(told + t_i * delta_t)
-            deformation = sd.lsetmeshadap.CalcDeformation(levelset)
+            deformation = sd.lsetmeshadap.CalcDeformation(levelset, incremental=True)
             ci.Update(sd.lsetmeshadap.lset_p1)
             hasneg_spacetime |= ci.GetElementsOfType(HASNEG)
             haspos_spacetime |= ci.GetElementsOfType(HASPOS)
@@ -432,7 +432,7 @@ def SolveProblem(sd, delta_t ):
             t.Set(told + t_i * delta_t)
             
             # calculate the mesh deformation at the current point in time
-            deformation = sd.lsetmeshadap.CalcDeformation(levelset)
+            deformation = sd.lsetmeshadap.CalcDeformation(levelset, incremental=True)
             
             # collect information about the current cut-situation
             ci.Update(sd.lsetmeshadap.lset_p1)
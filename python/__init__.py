@@ -135,6 +135,11 @@ levelset_domain : dictionary
     * first direction is used unless not applicable (FIRST)
     * best direction (in terms of transformation constant) is used (OPTIMAL)
     * subdivision into simplices is always used (FALLBACK)
+  * "highorder_lset" : boolean
+    (default: False)
+    If the level set is a higher order H1 GridFunction, the integration rule is constructed
+    directly on its (higher order) zero level (volume trigs, quads, tets and hexes only).
+    Otherwise only its vertex values are used.
 
 Other Parameters :
 
@@ -173,12 +178,15 @@ Other Parameters :
             print("Please provide a domain type (NEG,POS or IF)")
         if not "quad_dir_policy" in levelset_domain:
             levelset_domain["quad_dir_policy"] = OPTIMAL
+        if not "highorder_lset" in levelset_domain:
+            levelset_domain["highorder_lset"] = False
         # print("SymbolicBFI-Wrapper: SymbolicCutBFI called")
         return SymbolicCutBFI(lset=levelset_domain["levelset"],
                               domain_type=levelset_domain["domain_type"],
                               force_intorder=levelset_domain["force_intorder"],
                               subdivlvl=levelset_domain["subdivlvl"],
                               quad_dir_policy=levelset_domain["quad_dir_policy"],
+                              highorder_lset=levelset_domain["highorder_lset"],
                               *args, **kwargs)
     else:
         # print("SymbolicBFI-Wrapper: original SymbolicBFI called")
@@ -219,6 +227,11 @@ levelset_domain : dictionary
     * first direction is used unless not applicable (FIRST)
     * best direction (in terms of transformation constant) is used (OPTIMAL)
     * subdivision into simplices is always used (FALLBACK)
+  * "highorder_lset" : boolean
+    (default: False)
+    If the level set is a higher order H1 GridFunction, the integration rule is constructed
+    directly on its (higher order) zero level (volume trigs, quads, tets and hexes only).
+    Otherwise only its vertex values are used.
 
 Other Parameters :
 
@@ -257,12 +270,15 @@ Other Parameters :
             print("Please provide a domain type (NEG,POS or IF)")
         if not "quad_dir_policy" in levelset_domain:
             levelset_domain["quad_dir_policy"] = OPTIMAL
+        if not "highorder_lset" in levelset_domain:
+            levelset_domain["highorder_lset"] = False
         # print("SymbolicLFI-Wrapper: SymbolicCutLFI called")
         return SymbolicCutLFI(lset=levelset_domain["levelset"],
                               domain_type=levelset_domain["domain_type"],
                               force_intorder=levelset_domain["force_intorder"],
                               subdivlvl=levelset_domain["subdivlvl"],
                               quad_dir_policy=levelset_domain["quad_dir_policy"],
+                              highorder_lset=levelset_domain["highorder_lset"],
                               *args, **kwargs)
     else:
         # print("SymbolicLFI-Wrapper: original SymbolicLFI called")
@@ -289,6 +305,8 @@ See documentation of Integrate.
         print("Please provide a domain type (NEG,POS or IF)")
     if not "quad_dir_policy" in levelset_domain:
         levelset_domain["quad_dir_policy"] = OPTIMAL
+    if not "highorder_lset" in levelset_domain:
+        levelset_domain["highorder_lset"] = False
 
     return IntegrateX(lset=levelset_domain["levelset"],
                       mesh=mesh, cf=cf,
@@ -297,6 +315,7 @@ See documentation of Integrate.
                       subdivlvl=levelset_domain["subdivlvl"],
                       time_order=time_order,
                       quad_dir_policy=levelset_domain["quad_dir_policy"],
+                      highorder_lset=levelset_domain["highorder_lset"],
                       heapsize=heapsize)
 
 
@@ -335,6 +354,11 @@ levelset_domain : dictionary
     * first direction is used unless not applicable (FIRST)
     * best direction (in terms of transformation constant) is used (OPTIMAL)
     * subdivision into simplices is always used (FALLBACK)
+  * "highorder_lset" : boolean
+    (default: False)
+    If the level set is a higher order H1 GridFunction, the integration rule is constructed
+    directly on its (higher order) zero level (volume trigs, quads, tets and hexes only).
+    Otherwise only its vertex values are used.
 
 mesh :
   Mesh to integrate on (on some part)
@@ -430,3 +454,52 @@ combined with BitArrayCF).
     # cut = vectorize(cut)
     # kappa1.vec.FV().NumPy()[:] = cut(kappa1.vec.FV().NumPy())
     return kappa1
+
+RefineAtLevelSet_old = RefineAtLevelSet
+def RefineAtLevelSet(gf=None, lower=0.0, upper=0.0, heapsize=1000000, mark_only=False, levels=1, levelset=None):
+    """
+Mark mesh for refinement on all elements where the piecewise linear level set function gf has
+values in the interval [lower,upper] (default [0,0]). Several marking rounds can be done in one call.
+
+Parameters
+
+gf : ngsolve.GridFunction
+  Scalar piecewise (multi-)linear Gridfunction
+
+lower : float
+  smallest level set value of interest
+
+upper : float
+  largest level set value of interest
+
+heapsize : int
+  heapsize of local computations.
+
+mark_only : boolean
+  only compute the marked elements, but do not set the refinement flags of the mesh (only
+  for levels == 1).
+
+levels : int
+  number of marking rounds. Between two rounds the mesh is refined and gf is updated (by
+  interpolation of levelset if it is given, otherwise by prolongation). The marks of the last
+  round are set as refinement flags, i.e. the last refinement is left to the caller as for
+  levels == 1.
+
+levelset : ngsolve.CoefficientFunction / None
+  level set function that is interpolated into gf after each refinement.
+
+Returns
+
+BitArray of the elements marked in the last round.
+    """
+    if levels > 1 and mark_only:
+        raise Exception("RefineAtLevelSet: mark_only only for levels == 1")
+    mesh = gf.space.mesh
+    for level in range(levels-1):
+        RefineAtLevelSet_old(gf=gf, lower=lower, upper=upper, heapsize=heapsize)
+        mesh.Refine()
+        gf.space.Update()
+        gf.Update()
+        if levelset is not None:
+            InterpolateToP1(levelset,gf)
+    return RefineAtLevelSet_old(gf=gf, lower=lower, upper=upper, heapsize=heapsize, mark_only=mark_only)
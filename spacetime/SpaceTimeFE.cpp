@@ -4,6 +4,7 @@
 /* Date:   June 2017                                                 */
 /*********************************************************************/
 
+#define FILE_SPACETIMEFE_CPP
 #include <fem.hpp>
 #include "SpaceTimeFE.hpp"
 
@@ -12,12 +13,13 @@ namespace ngfem
 {
 
 
-   SpaceTimeFE :: SpaceTimeFE (ScalarFiniteElement<2>* s_FE, ScalarFiniteElement<1>* t_FE, bool aoverride_time, double atime)
+   template <int D>
+   SpaceTimeFE<D> :: SpaceTimeFE (ScalarFiniteElement<D>* s_FE, ScalarFiniteElement<1>* t_FE, bool aoverride_time, double atime)
     /*
       Call constructor for base class:
       number of dofs is (dofs in space) * (Dofs in time), maximal order is order
      */
-      : ScalarFiniteElement<2> ((s_FE->GetNDof())*(t_FE->GetNDof()), s_FE->Order())
+      : ScalarFiniteElement<D> ((s_FE->GetNDof())*(t_FE->GetNDof()), s_FE->Order())
     {
 
         sFE = s_FE;
@@ -26,34 +28,33 @@ namespace ngfem
         override_time = aoverride_time;
     }
 
-    void SpaceTimeFE :: CalcShape (const IntegrationPoint & ip,
-                                    BareSliceVector<> shape) const
+    template <int D>
+    void SpaceTimeFE<D> :: CalcShape (const IntegrationPoint & ip, double t,
+                                      BareSliceVector<> shape) const
     {
 
        if (tFE->Order() == 0)
           sFE->CalcShape(ip,shape);
        else
        {
-
-            Vector<> time_shape(tFE->GetNDof());
-            IntegrationPoint z(override_time ? time : ip(2));
-            tFE->CalcShape(z,time_shape);
-
-            Vector<> space_shape(sFE->GetNDof());
-            sFE->CalcShape(ip,space_shape);
-
-            // define shape functions
-            int ii = 0;
-            for(int j=0; j<tFE->GetNDof(); j++) {
-              for(int i=0; i<sFE->GetNDof(); i++) {
-                shape(ii++) = space_shape(i)*time_shape(j);
-              }
-            }
+            const int nt = tFE->GetNDof();
+            const int ns = sFE->GetNDof();
+            STACK_ARRAY(double, mem, nt);
+            FlatVector<> time_shape(nt, &mem[0]);
+            tFE->CalcShape(IntegrationPoint(t),time_shape);
+
+            // space shapes are computed into the first block, then expanded
+            // (last time block first, so that the first block is overwritten last)
+            sFE->CalcShape(ip,shape);
+            for(int j=nt-1; j>=0; j--)
+              for(int i=0; i<ns; i++)
+                shape(j*ns+i) = shape(i)*time_shape(j);
        }
      }
 
-    void SpaceTimeFE :: CalcDShape (const IntegrationPoint & ip,
-                                    BareSliceMatrix<> dshape) const
+    template <int D>
+    void SpaceTimeFE<D> :: CalcDShape (const IntegrationPoint & ip, double t,
+                                       BareSliceMatrix<> dshape) const
 
     {
       // matrix of derivatives:
@@ -61,49 +62,302 @@ namespace ngfem
          if (tFE->Order() == 0)
             sFE->CalcDShape(ip,dshape);
          else {
+            const int nt = tFE->GetNDof();
+            const int ns = sFE->GetNDof();
+            STACK_ARRAY(double, mem, nt);
+            FlatVector<> time_shape(nt, &mem[0]);
+            tFE->CalcShape(IntegrationPoint(t),time_shape);
 
-            Vector<> time_shape(tFE->GetNDof());
-            IntegrationPoint z(override_time ? time : ip(2));
-            tFE->CalcShape(z,time_shape);
-
-            Matrix<double> space_dshape(sFE->GetNDof(),2);
-            sFE->CalcDShape(ip,space_dshape);
-
-
-            int ii = 0;
-            for(int j = 0; j < tFE->GetNDof(); j++) {
-                for(int i=0; i< sFE->GetNDof(); i++) {
-                    dshape(ii,0) = space_dshape(i,0)*time_shape(j);
-                    dshape(ii,1) = space_dshape(i,1)*time_shape(j);
-                    ii++;
-                }
-            }
+            sFE->CalcDShape(ip,dshape);
+            for(int j = nt-1; j >= 0; j--)
+              for(int i=0; i< ns; i++)
+                for(int d=0; d < D; d++)
+                  dshape(j*ns+i,d) = dshape(i,d)*time_shape(j);
          }
 
     }
 
     // for time derivatives
 
-    void SpaceTimeFE :: CalcDtShape (const IntegrationPoint & ip,
-                                     BareSliceVector<> dshape) const
+    template <int D>
+    void SpaceTimeFE<D> :: CalcDtShape (const IntegrationPoint & ip, double t,
+                                        BareSliceVector<> dshape) const
 
     {
         // matrix of derivatives:
+           const int nt = tFE->GetNDof();
+           const int ns = sFE->GetNDof();
+           STACK_ARRAY(double, mem, nt);
+           FlatMatrix<> time_dshape(nt, 1, &mem[0]);
+           tFE->CalcDShape(IntegrationPoint(t),time_dshape);
+
+           sFE->CalcShape(ip,dshape);
+           for(int j = nt-1; j >= 0; j--)
+              for(int i=0; i< ns; i++)
+                 dshape(j*ns+i) = dshape(i)*time_dshape(j,0);
+
+    }
+
+    template <int D>
+    double SpaceTimeFE<D> :: Evaluate (const IntegrationPoint & ip,
+                                       BareSliceVector<> coefs) const
+    {
+      if (tFE->Order() == 0)
+        return sFE->Evaluate(ip, coefs);
+
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(double, mem, nt+ns);
+      FlatVector<> time_shape(nt, &mem[0]);
+      FlatVector<> space_coefs(ns, &mem[nt]);
+      tFE->CalcShape(IntegrationPoint(TimeOf(ip)), time_shape);
+
+      space_coefs = 0.0;
+      for (int j = 0; j < nt; j++)
+        for (int i = 0; i < ns; i++)
+          space_coefs(i) += time_shape(j) * coefs(j*ns+i);
+      return sFE->Evaluate(ip, space_coefs);
+    }
+
+    template <int D>
+    Vec<D> SpaceTimeFE<D> :: EvaluateGrad (const IntegrationPoint & ip,
+                                           BareSliceVector<> coefs) const
+    {
+      if (tFE->Order() == 0)
+        return sFE->EvaluateGrad(ip, coefs);
+
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(double, mem, nt+ns);
+      FlatVector<> time_shape(nt, &mem[0]);
+      FlatVector<> space_coefs(ns, &mem[nt]);
+      tFE->CalcShape(IntegrationPoint(TimeOf(ip)), time_shape);
+
+      space_coefs = 0.0;
+      for (int j = 0; j < nt; j++)
+        for (int i = 0; i < ns; i++)
+          space_coefs(i) += time_shape(j) * coefs(j*ns+i);
+      return sFE->EvaluateGrad(ip, space_coefs);
+    }
+
+    template <int D>
+    void SpaceTimeFE<D> :: CalcTimeShape (const SIMD_IntegrationRule & ir,
+                                          BareSliceMatrix<SIMD<double>> tshapes) const
+    {
+      constexpr int W = SIMD<double>::Size();
+      const int nt = tFE->GetNDof();
+      STACK_ARRAY(double, mem, nt*(W+1));
+      FlatMatrix<> lanes(nt, W, &mem[0]);
+      FlatVector<> time_shape(nt, &mem[nt*W]);
+
+      if (override_time)
+        tFE->CalcShape(IntegrationPoint(time), time_shape);
+      else if (D == 3)
+        // no time coordinate in a 3D SIMD point: the generic integrators fall
+        // back to the scalar path (see TimeOf)
+        throw ExceptionNOSIMD("SpaceTimeFE<3>: no SIMD evaluation without a fixed time");
+      auto nodal_tFE = dynamic_cast<NodalTimeFE*>(tFE);
+      if (nodal_tFE && !override_time)
+      {
+        SIMD<double> vals[NodalTimeFE::MAX_NODES];
+        for (size_t k = 0; k < ir.Size(); k++)
+        {
+          nodal_tFE->CalcActiveShape(ir[k](2), vals);
+          for (int j = 0; j < nt; j++)
+            tshapes(j,k) = vals[j];
+        }
+        return;
+      }
+      for (size_t k = 0; k < ir.Size(); k++)
+      {
+        if (!override_time)
+          for (int l = 0; l < W; l++)
+          {
+            tFE->CalcShape(IntegrationPoint(ir[k](2)[l]), time_shape);
+            lanes.Col(l) = time_shape;
+          }
+        for (int j = 0; j < nt; j++)
+          tshapes(j,k) = override_time ? SIMD<double>(time_shape(j)) : SIMD<double>(&lanes(j,0));
+      }
+    }
+
+    template <int D>
+    void SpaceTimeFE<D> :: CalcShape (const SIMD_IntegrationRule & ir,
+                                      BareSliceMatrix<SIMD<double>> shapes) const
+    {
+      if (tFE->Order() == 0)
+      {
+        sFE->CalcShape(ir,shapes);
+        return;
+      }
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(SIMD<double>, mem, nt*ir.Size());
+      FlatMatrix<SIMD<double>> tshapes(nt, ir.Size(), &mem[0]);
+      CalcTimeShape(ir, tshapes);
+
+      sFE->CalcShape(ir,shapes);
+      for (int j = nt-1; j >= 0; j--)
+        for (int i = 0; i < ns; i++)
+          for (size_t k = 0; k < ir.Size(); k++)
+            shapes(j*ns+i,k) = shapes(i,k) * tshapes(j,k);
+    }
+
+    template <int D>
+    void SpaceTimeFE<D> :: CalcMappedDShape (const SIMD_BaseMappedIntegrationRule & mir,
+                                             BareSliceMatrix<SIMD<double>> dshapes) const
+    {
+      if (tFE->Order() == 0)
+      {
+        sFE->CalcMappedDShape(mir,dshapes);
+        return;
+      }
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(SIMD<double>, mem, nt*mir.Size());
+      FlatMatrix<SIMD<double>> tshapes(nt, mir.Size(), &mem[0]);
+      CalcTimeShape(mir.IR(), tshapes);
+
+      sFE->CalcMappedDShape(mir,dshapes);
+      for (int j = nt-1; j >= 0; j--)
+        for (int i = 0; i < ns; i++)
+          for (int d = 0; d < D; d++)
+            for (size_t k = 0; k < mir.Size(); k++)
+              dshapes((j*ns+i)*D+d,k) = dshapes(i*D+d,k) * tshapes(j,k);
+    }
+
+    template <int D>
+    void SpaceTimeFE<D> :: Evaluate (const SIMD_IntegrationRule & ir,
+                                     BareSliceVector<> coefs,
+                                     BareVector<SIMD<double>> values) const
+    {
+      if (tFE->Order() == 0)
+      {
+        sFE->Evaluate(ir,coefs,values);
+        return;
+      }
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(SIMD<double>, mem, (nt+1)*ir.Size());
+      FlatMatrix<SIMD<double>> tshapes(nt, ir.Size(), &mem[0]);
+      FlatVector<SIMD<double>> space_values(ir.Size(), &mem[nt*ir.Size()]);
+      CalcTimeShape(ir, tshapes);
+
+      for (size_t k = 0; k < ir.Size(); k++)
+        values(k) = SIMD<double>(0.0);
+      for (int j = 0; j < nt; j++)
+      {
+        sFE->Evaluate(ir, coefs.Range(j*ns,(j+1)*ns), space_values);
+        for (size_t k = 0; k < ir.Size(); k++)
+          values(k) += tshapes(j,k) * space_values(k);
+      }
+    }
+
+    template <int D>
+    void SpaceTimeFE<D> :: EvaluateGrad (const SIMD_BaseMappedIntegrationRule & mir,
+                                         BareSliceVector<> coefs,
+                                         BareSliceMatrix<SIMD<double>> values) const
+    {
+      if (tFE->Order() == 0)
+      {
+        sFE->EvaluateGrad(mir,coefs,values);
+        return;
+      }
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(SIMD<double>, mem, (nt+D)*mir.Size());
+      FlatMatrix<SIMD<double>> tshapes(nt, mir.Size(), &mem[0]);
+      FlatMatrix<SIMD<double>> space_values(D, mir.Size(), &mem[nt*mir.Size()]);
+      CalcTimeShape(mir.IR(), tshapes);
+
+      for (int d = 0; d < D; d++)
+        for (size_t k = 0; k < mir.Size(); k++)
+          values(d,k) = SIMD<double>(0.0);
+      for (int j = 0; j < nt; j++)
+      {
+        sFE->EvaluateGrad(mir, coefs.Range(j*ns,(j+1)*ns), space_values);
+        for (int d = 0; d < D; d++)
+          for (size_t k = 0; k < mir.Size(); k++)
+            values(d,k) += tshapes(j,k) * space_values(d,k);
+      }
+    }
 
-           Matrix<double> time_dshape(tFE->GetNDof(),1);
-           IntegrationPoint z(override_time ? time : ip(2));
-           tFE->CalcDShape(z,time_dshape);
+    template <int D>
+    void SpaceTimeFE<D> :: AddTrans (const SIMD_IntegrationRule & ir,
+                                     BareVector<SIMD<double>> values,
+                                     BareSliceVector<> coefs) const
+    {
+      if (tFE->Order() == 0)
+      {
+        sFE->AddTrans(ir,values,coefs);
+        return;
+      }
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(SIMD<double>, mem, (nt+1)*ir.Size());
+      FlatMatrix<SIMD<double>> tshapes(nt, ir.Size(), &mem[0]);
+      FlatVector<SIMD<double>> time_values(ir.Size(), &mem[nt*ir.Size()]);
+      CalcTimeShape(ir, tshapes);
+
+      for (int j = 0; j < nt; j++)
+      {
+        for (size_t k = 0; k < ir.Size(); k++)
+          time_values(k) = tshapes(j,k) * values(k);
+        sFE->AddTrans(ir, time_values, coefs.Range(j*ns,(j+1)*ns));
+      }
+    }
+
+    template <int D>
+    void SpaceTimeFE<D> :: AddGradTrans (const SIMD_BaseMappedIntegrationRule & mir,
+                                         BareSliceMatrix<SIMD<double>> values,
+                                         BareSliceVector<> coefs) const
+    {
+      if (tFE->Order() == 0)
+      {
+        sFE->AddGradTrans(mir,values,coefs);
+        return;
+      }
+      const int nt = tFE->GetNDof();
+      const int ns = sFE->GetNDof();
+      STACK_ARRAY(SIMD<double>, mem, (nt+D)*mir.Size());
+      FlatMatrix<SIMD<double>> tshapes(nt, mir.Size(), &mem[0]);
+      FlatMatrix<SIMD<double>> time_values(D, mir.Size(), &mem[nt*mir.Size()]);
+      CalcTimeShape(mir.IR(), tshapes);
+
+      for (int j = 0; j < nt; j++)
+      {
+        for (int d = 0; d < D; d++)
+          for (size_t k = 0; k < mir.Size(); k++)
+            time_values(d,k) = tshapes(j,k) * values(d,k);
+        sFE->AddGradTrans(mir, time_values, coefs.Range(j*ns,(j+1)*ns));
+      }
+    }
 
-           Vector<> space_shape(sFE->GetNDof());
-           sFE->CalcShape(ip,space_shape);
+    template class SpaceTimeFE<2>;
+    template class SpaceTimeFE<3>;
 
-           int ii = 0;
-           for(int j = 0; j < tFE->GetNDof(); j++) {
-              for(int i=0; i< sFE->GetNDof(); i++) {
-                 dshape(ii++) = space_shape(i)*time_dshape(j,0);
-              }
-           }
 
+    void CalcBernsteinTrafo (const ScalarFiniteElement<1> & fe_time, SliceMatrix<> trafo)
+    {
+      // the degree is the order of the element, not ndof-1 (skip_first_node
+      // and only_first_node elements have less dofs)
+      const int p = fe_time.Order();
+      const int n = p+1;
+      Matrix<> bmat(n, n);
+      Matrix<> phi(n, fe_time.GetNDof());
+      Vector<> binom(n);
+      binom(0) = 1;
+      for (int j = 1; j < n; j++)
+        binom(j) = binom(j-1) * (p-j+1) / j;
+      for (int k = 0; k < n; k++)
+      {
+        const double x = p > 0 ? double(k) / p : 0.0;
+        for (int j = 0; j < n; j++)
+          bmat(k,j) = binom(j) * pow(x,j) * pow(1-x,p-j);
+        fe_time.CalcShape(IntegrationPoint(Vec<3>{x,0,0}, 0.), phi.Row(k));
+      }
+      CalcInverse(bmat);
+      trafo = bmat * phi;
     }
 
 
@@ -113,32 +367,50 @@ namespace ngfem
       {
          k_t = order;
          CalcInterpolationPoints ();
+         bernstein_trafo.SetSize(order+1, ndof);
+         CalcBernsteinTrafo (*this, bernstein_trafo);
       }
 
 
       void NodalTimeFE :: CalcShape (const IntegrationPoint & ip,
                                      BareSliceVector<> shape) const
       {
-         AutoDiff<1> adx (ip(0), 0);
-         int begin = skip_first_node ? 1 : 0;
-         int end = only_first_node ? 1 : ndof+begin;
-         int cnt = 0;
-         for(int i = begin; i < end; i++) {
-             shape(cnt++) = Lagrange_Pol (adx, i).Value() ;
-         }
+         double vals[MAX_NODES];
+         CalcActiveShape (ip(0), vals);
+         for (int i = 0; i < ndof; i++)
+             shape(i) = vals[i];
       }
 
 
       void NodalTimeFE :: CalcDShape (const IntegrationPoint & ip,
                                       BareSliceMatrix<> dshape) const
       {
-         AutoDiff<1> adx (ip(0), 0);
-         int begin = skip_first_node ? 1 : 0;
-         int end = only_first_node ? 1 : ndof+begin;
-         int cnt = 0;
-         for(int i = begin; i < end; i++) {
-             dshape(cnt++,0) = Lagrange_Pol(adx, i).DValue(0);
-          }
+         AutoDiff<1> vals[MAX_NODES];
+         CalcActiveShape (AutoDiff<1> (ip(0), 0), vals);
+         for (int i = 0; i < ndof; i++)
+             dshape(i,0) = vals[i].DValue(0);
+      }
+
+      void NodalTimeFE :: CalcShape (const IntegrationRule & ir,
+                                     SliceMatrix<> shape) const
+      {
+         double vals[MAX_NODES];
+         for (int k = 0; k < ir.Size(); k++) {
+             CalcActiveShape (ir[k](0), vals);
+             for (int i = 0; i < ndof; i++)
+                 shape(i,k) = vals[i];
+         }
+      }
+
+      void NodalTimeFE :: CalcShape (const SIMD_IntegrationRule & ir,
+                                     BareSliceMatrix<SIMD<double>> shapes) const
+      {
+         SIMD<double> vals[MAX_NODES];
+         for (size_t k = 0; k < ir.Size(); k++) {
+             CalcActiveShape (ir[k](0), vals);
+             for (int i = 0; i < ndof; i++)
+                 shapes(i,k) = vals[i];
+         }
       }
 
       void NodalTimeFE :: CalcInterpolationPoints ()
@@ -162,6 +434,15 @@ namespace ngfem
                    nodes[5] = 1.0;  break;
           default : throw Exception("Requested TimeFE not implemented yet.");
          }
+
+         bary_weights.SetSize(order+1);
+         for (int i = 0; i <= order; i++) {
+             double w = 1.0;
+             for (int j = 0; j <= order; j++)
+                 if (j != i)
+                     w *= nodes[i] - nodes[j];
+             bary_weights[i] = 1.0 / w;
+         }
       }
 
 
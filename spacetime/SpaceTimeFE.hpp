@@ -16,36 +16,122 @@ namespace ngfem
 {
 
 
-    class SpaceTimeFE : public ScalarFiniteElement<2>
+    /**
+       tensor product of a spatial element (D = 2 or 3) and a time element.
+
+       The time of a space-time integration point is stored in the
+       coordinate after the spatial ones (ip(2) in 2D). In 3D there is no
+       free coordinate, here the time has to be fixed (override_time) or
+       passed explicitly (see fix_t).
+    */
+    template <int D>
+    class SpaceTimeFE : public ScalarFiniteElement<D>
    {
-        ScalarFiniteElement<2>* sFE = nullptr;
+        ScalarFiniteElement<D>* sFE = nullptr;
         ScalarFiniteElement<1>* tFE = nullptr;
         double time;
         bool override_time = false;
 
     public:
       // constructor
-      SpaceTimeFE (ScalarFiniteElement<2>* s_FE,ScalarFiniteElement<1>*t_FE, bool override_time, double time );
+      SpaceTimeFE (ScalarFiniteElement<D>* s_FE,ScalarFiniteElement<1>*t_FE, bool override_time, double time );
 
-      virtual ELEMENT_TYPE ElementType() const { return ET_TRIG; }
+      virtual ELEMENT_TYPE ElementType() const { return sFE->ElementType(); }
+
+      ScalarFiniteElement<D>* GetSpaceFE() const { return sFE; }
+      ScalarFiniteElement<1>* GetTimeFE() const { return tFE; }
 
 
       virtual void CalcShape (const IntegrationPoint & ip,
-                              BareSliceVector<> shape) const;
+                              BareSliceVector<> shape) const
+      { CalcShape (ip, TimeOf(ip), shape); }
 
       // for time derivatives
 
       virtual void CalcDtShape (const IntegrationPoint & ip,
-                               BareSliceVector<> dshape) const;
+                               BareSliceVector<> dshape) const
+      { CalcDtShape (ip, TimeOf(ip), dshape); }
 
       virtual void CalcDShape (const IntegrationPoint & ip,
-                               BareSliceMatrix<> dshape) const;
+                               BareSliceMatrix<> dshape) const
+      { CalcDShape (ip, TimeOf(ip), dshape); }
+
+      // evaluations at an explicitly given time t (spatial coordinates from ip)
+
+      void CalcShape (const IntegrationPoint & ip, double t,
+                      BareSliceVector<> shape) const;
+
+      void CalcDtShape (const IntegrationPoint & ip, double t,
+                        BareSliceVector<> dshape) const;
+
+      void CalcDShape (const IntegrationPoint & ip, double t,
+                       BareSliceMatrix<> dshape) const;
+
+      // sum-factorized evaluations: the coefficients are first contracted
+      // with the time shape functions, then the spatial element is used
+
+      virtual double Evaluate (const IntegrationPoint & ip,
+                               BareSliceVector<> coefs) const;
+
+      virtual Vec<D> EvaluateGrad (const IntegrationPoint & ip,
+                                   BareSliceVector<> coefs) const;
+
+      // SIMD versions (time coordinate from ir[k](2) in 2D)
+
+      virtual void CalcShape (const SIMD_IntegrationRule & ir,
+                              BareSliceMatrix<SIMD<double>> shapes) const;
+
+      virtual void CalcMappedDShape (const SIMD_BaseMappedIntegrationRule & mir,
+                                     BareSliceMatrix<SIMD<double>> dshapes) const;
+
+      virtual void Evaluate (const SIMD_IntegrationRule & ir,
+                             BareSliceVector<> coefs,
+                             BareVector<SIMD<double>> values) const;
+
+      virtual void EvaluateGrad (const SIMD_BaseMappedIntegrationRule & mir,
+                                 BareSliceVector<> coefs,
+                                 BareSliceMatrix<SIMD<double>> values) const;
+
+      virtual void AddTrans (const SIMD_IntegrationRule & ir,
+                             BareVector<SIMD<double>> values,
+                             BareSliceVector<> coefs) const;
 
-      // there are some more functions to bring in ...
-      //using ScalarFiniteElement<2>::CalcShape;
-      //using ScalarFiniteElement<2>::CalcDShape;
+      virtual void AddGradTrans (const SIMD_BaseMappedIntegrationRule & mir,
+                                 BareSliceMatrix<SIMD<double>> values,
+                                 BareSliceVector<> coefs) const;
+
+      using ScalarFiniteElement<D>::CalcShape;
+      using ScalarFiniteElement<D>::CalcDShape;
+      using ScalarFiniteElement<D>::CalcMappedDShape;
+      using ScalarFiniteElement<D>::Evaluate;
+      using ScalarFiniteElement<D>::EvaluateGrad;
+      using ScalarFiniteElement<D>::AddTrans;
+      using ScalarFiniteElement<D>::AddGradTrans;
+
+      double TimeOf (const IntegrationPoint & ip) const
+      {
+        if (override_time)
+          return time;
+        if (D == 3)
+          throw Exception("SpaceTimeFE<3>: time can not be taken from a 3D point, fix the time (SetTime / fix_t)");
+        return ip(2);
+      }
+
+    private:
+      /// time shape functions at all points (and lanes) of a SIMD rule
+      void CalcTimeShape (const SIMD_IntegrationRule & ir,
+                          BareSliceMatrix<SIMD<double>> tshapes) const;
     };
 
+#ifndef FILE_SPACETIMEFE_CPP
+    extern template class SpaceTimeFE<2>;
+    extern template class SpaceTimeFE<3>;
+#endif
+
+
+    /// matrix (order+1 x ndof) mapping coefficients of a time element to the
+    /// Bernstein coefficients of the same polynomial of degree fe_time.Order()
+    void CalcBernsteinTrafo (const ScalarFiniteElement<1> & fe_time, SliceMatrix<> trafo);
 
     class NodalTimeFE : public ScalarFiniteElement<1>
       {
@@ -54,8 +140,15 @@ namespace ngfem
         bool skip_first_node = false;
         bool only_first_node = false;
         Array<double> nodes;
+        // barycentric weights 1 / prod_{j!=i} (x_i - x_j), set up with the nodes
+        Array<double> bary_weights;
+        // see CalcBernsteinTrafo, set up once with the element
+        Matrix<> bernstein_trafo;
 
       public:
+        // nodes of the highest implemented order (see CalcInterpolationPoints)
+        static constexpr int MAX_NODES = 6;
+
         NodalTimeFE (int order, bool askip_first_node, bool aonly_first_node);
         virtual ELEMENT_TYPE ElementType() const { return ET_SEGM; }
         void SetVertexNumber (int i, int v) { vnums[i] = v; }
@@ -66,6 +159,15 @@ namespace ngfem
         virtual void CalcDShape (const IntegrationPoint & ip,
                                  BareSliceMatrix<> dshape) const;
 
+        // shapes at all points of a rule (shape is ndof x npoints)
+        virtual void CalcShape (const IntegrationRule & ir,
+                                SliceMatrix<> shape) const;
+
+        virtual void CalcShape (const SIMD_IntegrationRule & ir,
+                                BareSliceMatrix<SIMD<double>> shapes) const;
+
+        using ScalarFiniteElement<1>::CalcShape;
+
         bool IsNodeActive(int i) const
         {
           if (i<0 || i > k_t+1)
@@ -81,17 +183,36 @@ namespace ngfem
         void CalcInterpolationPoints ();
         Array<double> & GetNodes() { return nodes; }
         int order_time() const { return k_t; }
+        const Matrix<> & GetBernsteinTrafo() const { return bernstein_trafo; }
 
+        // all Lagrange polynomials (active or not) at x: prefix and suffix
+        // products of (x - x_j) times the barycentric weights, no divisions
+        // (T = double, AutoDiff<1> or SIMD<double>)
         template <class T>
-        T Lagrange_Pol (T x, int i) const
+        void CalcLagrangePols (T x, T * vals) const
         {
-           T result  = 1;
-           for (int j = 0; j < nodes.Size(); j++) {
-               if ( j != i)
-                    result *= ( x-nodes[j] ) / ( nodes[i] - nodes[j] );
+           const int n = nodes.Size();
+           T prefix = 1.0;
+           for (int i = 0; i < n; i++) {
+               vals[i] = prefix;
+               prefix *= x - nodes[i];
+           }
+           T suffix = 1.0;
+           for (int i = n-1; i >= 0; i--) {
+               vals[i] *= suffix * bary_weights[i];
+               suffix *= x - nodes[i];
            }
+        }
 
-           return result;
+        // shape functions of the active nodes at x
+        template <class T>
+        void CalcActiveShape (T x, T * shape) const
+        {
+           T vals[MAX_NODES];
+           CalcLagrangePols (x, vals);
+           const int begin = skip_first_node ? 1 : 0;
+           for (int i = 0; i < ndof; i++)
+               shape[i] = vals[begin+i];
         }
 
       };
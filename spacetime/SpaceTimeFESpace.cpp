@@ -11,6 +11,7 @@
 #include <nginterface.h>
 #include "SpaceTimeFESpace.hpp"
 
+#include "../utils/ngsxstd.hpp"
 #include "../utils/p1interpol.hpp"
 
 /*
@@ -43,9 +44,21 @@ SpaceTimeFESpace :: SpaceTimeFESpace (shared_ptr<MeshAccess> ama, shared_ptr<FES
     cout << IM(3) <<"Order Time: " << order_t << endl;
 
     // needed to draw solution function
-    evaluator[VOL] = make_shared<T_DifferentialOperator<DiffOpId<2>>>();
-    flux_evaluator[VOL] = make_shared<T_DifferentialOperator<DiffOpGradient<2>>>();
-    evaluator[BND] = make_shared<T_DifferentialOperator<DiffOpIdBoundary<2>>>();
+    switch (ma->GetDimension())
+    {
+      case 2:
+        evaluator[VOL] = make_shared<T_DifferentialOperator<DiffOpId<2>>>();
+        flux_evaluator[VOL] = make_shared<T_DifferentialOperator<DiffOpGradient<2>>>();
+        evaluator[BND] = make_shared<T_DifferentialOperator<DiffOpIdBoundary<2>>>();
+        break;
+      case 3:
+        evaluator[VOL] = make_shared<T_DifferentialOperator<DiffOpId<3>>>();
+        flux_evaluator[VOL] = make_shared<T_DifferentialOperator<DiffOpGradient<3>>>();
+        evaluator[BND] = make_shared<T_DifferentialOperator<DiffOpIdBoundary<3>>>();
+        break;
+      default:
+        throw Exception("SpaceTimeFESpace: only 2D and 3D spatial meshes are supported");
+    }
 
     integrator[VOL] = GetIntegrators().CreateBFI("mass", ma->GetDimension(),
                                                  make_shared<ConstantCoefficientFunction>(1));
@@ -111,108 +124,195 @@ SpaceTimeFESpace :: SpaceTimeFESpace (shared_ptr<MeshAccess> ama, shared_ptr<FES
   FiniteElement & SpaceTimeFESpace :: GetFE (ElementId ei, Allocator & alloc) const
   {
 
-     ScalarFiniteElement<2>* s_FE = dynamic_cast<ScalarFiniteElement<2>*>(&(Vh->GetFE(ei,alloc)));
      ScalarFiniteElement<1>* t_FE = tfe;
-     SpaceTimeFE * st_FE =  new (alloc) SpaceTimeFE(s_FE,t_FE,override_time,time);
+     if (ma->GetDimension() == 3)
+     {
+       ScalarFiniteElement<3>* s_FE = dynamic_cast<ScalarFiniteElement<3>*>(&(Vh->GetFE(ei,alloc)));
+       return *new (alloc) SpaceTimeFE<3>(s_FE,t_FE,override_time,time);
+     }
+     ScalarFiniteElement<2>* s_FE = dynamic_cast<ScalarFiniteElement<2>*>(&(Vh->GetFE(ei,alloc)));
+     SpaceTimeFE<2> * st_FE =  new (alloc) SpaceTimeFE<2>(s_FE,t_FE,override_time,time);
 
      return *st_FE;
 
    }
 
-  template<typename SCAL>
   void SpaceTimeFESpace :: RestrictGFInTime(shared_ptr<GridFunction> st_GF, double time, shared_ptr<GridFunction> s_GF)
   {
-     auto st_vec = st_GF->GetVectorPtr()->FV<SCAL>();   
-     auto restricted_vec = s_GF->GetVectorPtr()->FV<SCAL>();
-     //restricted_vec = SCAL(0.0);
-
-     Array<double> & nodes = TimeFE_nodes();
-
-     //cout << "Vhdim = " << Vh->GetDimension() << endl;
-     // Using nodal property for special case
-     int cnt = 0;
-     for(int i= 0; i < nodes.Size(); i++) {
-         if (!IsTimeNodeActive(i))
-           continue;
-         if(time == nodes[i]) {
-             cout << IM(3) <<"Node case" << endl;
-             for(int j = 0; j < Vh->GetNDof();j++)
-                 restricted_vec[j] = st_vec[j+cnt*Vh->GetNDof()];
-             return;
-         }
-         cnt++;
-     }
-     cout << IM(3) <<"General case" << endl;
-     // General case
-     //cout << IM(3) <<"time fe:" << GetTimeFE() << endl;
-     NodalTimeFE * time_FE = dynamic_cast<NodalTimeFE*>(tfe);
-     const int dim = Vh->GetDimension();     
-     for(int i= 0; i < nodes.Size(); i++) {
-       if (IsTimeNodeActive(i))
-       {
-         double weight_time = time_FE->Lagrange_Pol(time,i);
-         for(int j = 0; j < Vh->GetNDof();j++)
-             for(int d = 0; d < dim;d++)
-                 restricted_vec[dim*j+d] += weight_time * st_vec[dim*(j+i*Vh->GetNDof())+d];
-       }
-     }
+    Array<double> times { time };
+    Array<shared_ptr<GridFunction>> s_GFs { s_GF };
+    RestrictGFInTime(st_GF, times, s_GFs);
+  }
+
+  void SpaceTimeFESpace :: RestrictGFInTime(shared_ptr<GridFunction> st_GF, FlatArray<double> times, FlatArray<shared_ptr<GridFunction>> s_GFs)
+  {
+    static Timer timer ("SpaceTimeFESpace::RestrictGFInTime");
+    RegionTimer reg(timer);
+
+    if (times.Size() != s_GFs.Size())
+      throw Exception("SpaceTimeFESpace::RestrictGFInTime: number of times and GridFunctions differ");
+
+    NodalTimeFE * time_FE = dynamic_cast<NodalTimeFE*>(tfe);
+    Array<double> & nodes = TimeFE_nodes();
+    Array<int> active_nodes;
+    for (int i = 0; i < nodes.Size(); i++)
+      if (IsTimeNodeActive(i))
+        active_nodes.Append(i);
+    const int na = active_nodes.Size();
+    const int nt = times.Size();
+
+    // weights of the time nodes for every time (nodal property used at nodes)
+    Matrix<> weights(nt, na);
+    for (int k = 0; k < nt; k++)
+    {
+      int node = -1;
+      for (int l = 0; l < na; l++)
+        if (times[k] == nodes[active_nodes[l]])
+          node = l;
+      if (node >= 0)
+        for (int l = 0; l < na; l++)
+          weights(k,l) = l == node ? 1.0 : 0.0;
+      else
+        time_FE->CalcShape(IntegrationPoint(times[k]), weights.Row(k));
+    }
+
+    // all components of all spatial dofs of one time node are one contiguous block
+    const size_t nblock = Vh->GetNDof() * Vh->GetDimension();
+    FlatVector<> st_vec = st_GF->GetVector().FVDouble();
+    if (st_vec.Size() != na * nblock)
+      throw Exception("SpaceTimeFESpace::RestrictGFInTime: space-time vector does not fit to the space");
+    Array<FlatVector<>> s_vecs(nt);
+    for (int k = 0; k < nt; k++)
+    {
+      FlatVector<> s_vec = s_GFs[k]->GetVector().FVDouble();
+      if (s_vec.Size() != nblock)
+        throw Exception("SpaceTimeFESpace::RestrictGFInTime: spatial GridFunction does not fit to the space");
+      s_vecs[k].AssignMemory(nblock, &s_vec(0));
+    }
+
+    ParallelForRange (Range(nblock), [&](IntRange r)
+    {
+      const size_t first = r.First(), next = r.Next();
+      for (int k = 0; k < nt; k++)
+        s_vecs[k].Range(first, next) = 0.0;
+      for (int l = 0; l < na; l++)
+      {
+        FlatVector<> st_block = st_vec.Range(l*nblock + first, l*nblock + next);
+        for (int k = 0; k < nt; k++)
+          if (weights(k,l) != 0.0)
+            s_vecs[k].Range(first, next) += weights(k,l) * st_block;
+      }
+    });
   }
 
-  
   shared_ptr<GridFunction> SpaceTimeFESpace :: CreateRestrictedGF(shared_ptr<GridFunction> st_GF, double time)
   {
-     shared_ptr<GridFunction> restricted_GF = nullptr;
-     
-     switch (Vh->GetDimension())
+     Array<double> times { time };
+     return CreateRestrictedGFs(st_GF, times)[0];
+  }
+
+  Array<shared_ptr<GridFunction>> SpaceTimeFESpace :: CreateRestrictedGFs(shared_ptr<GridFunction> st_GF, FlatArray<double> times)
+  {
+     Array<shared_ptr<GridFunction>> restricted_GFs(times.Size());
+     for (int k = 0; k < times.Size(); k++)
      {
-       case 1:
-         restricted_GF = make_shared < T_GridFunction < double > >( Vh_ptr);
-         restricted_GF->Update();
-         RestrictGFInTime<double>(st_GF, time, restricted_GF);
-         break;
-       case 2:
-         restricted_GF = make_shared < T_GridFunction < Vec<2> > >( Vh_ptr);
-         restricted_GF->Update();
-         RestrictGFInTime<Vec<2>>(st_GF, time, restricted_GF);
-         break;
-     
-       default:
-         throw Exception("cannot handle GridFunction type (dimension too large?).");
-         break;
+       switch (Vh->GetDimension())
+       {
+         case 1:
+           restricted_GFs[k] = make_shared < T_GridFunction < double > >( Vh_ptr);
+           break;
+         case 2:
+           restricted_GFs[k] = make_shared < T_GridFunction < Vec<2> > >( Vh_ptr);
+           break;
+         case 3:
+           restricted_GFs[k] = make_shared < T_GridFunction < Vec<3> > >( Vh_ptr);
+           break;
+         default:
+           throw Exception("cannot handle GridFunction type (dimension too large?).");
+           break;
+       }
+       restricted_GFs[k]->Update();
      }
-
-     return restricted_GF;
+     RestrictGFInTime(st_GF, times, restricted_GFs);
+     return restricted_GFs;
   }
 
   void SpaceTimeFESpace ::InterpolateToP1(shared_ptr<CoefficientFunction> st_CF, shared_ptr<CoefficientFunction> ctref, double t, double dt, shared_ptr<GridFunction> st_GF)
   {
-    LocalHeapMem<100000> lh("SpacetimeInterpolateToP1");
-    auto node_gf = make_shared < T_GridFunction < double > >( Vh_ptr);
-    node_gf->Update();
-    auto gf_vec = st_GF->GetVectorPtr()->FV<double>();
-    auto node_gf_vec = node_gf->GetVectorPtr()->FV<double>();
-    shared_ptr<ParameterCoefficientFunction> coef_tref = dynamic_pointer_cast<ParameterCoefficientFunction>(ctref);
-    if (!coef_tref)
-      throw Exception("SpaceTimeFESpace ::InterpolateToP1 : tref is not a ParameterCF");
-    const double backup_tref = coef_tref->GetValue();
+    static Timer timer ("SpaceTimeFESpace::InterpolateToP1");
+    RegionTimer reg(timer);
+
+    const int D = ma->GetDimension();
+    shared_ptr<ParameterCoefficientFunction> coef_tref = nullptr;
+    if (ctref)
+    {
+      coef_tref = dynamic_pointer_cast<ParameterCoefficientFunction>(ctref);
+      if (!coef_tref)
+        throw Exception("SpaceTimeFESpace ::InterpolateToP1 : tref is not a ParameterCF");
+    }
+    else if (D != 2)
+      throw Exception("SpaceTimeFESpace ::InterpolateToP1 : the reference time can only be passed in the integration point on 2D meshes, provide a time parameter");
+
     Array<double> & nodes = TimeFE_nodes();
-    for(int i= 0; i < nodes.Size(); i++) {
+    Array<double> active_times;
+    for (int i = 0; i < nodes.Size(); i++)
       if (IsTimeNodeActive(i))
+        active_times.Append(nodes[i]);
+
+    const size_t ndof_s = Vh->GetNDof();
+    FlatVector<> gf_vec = st_GF->GetVector().FVDouble();
+    gf_vec = 0.0;
+
+    LocalHeap clh (1000000, "SpaceTimeFESpace::InterpolateToP1", true);
+
+    // evaluate st_CF in all vertices for the active time nodes [first, next) and
+    // write the values directly into the blocks of these nodes
+    const int nv = ma->GetNV();
+    Matrix<> vertex_vals(active_times.Size(), nv);
+    auto interpolate = [&] (int first, int next, bool time_in_ip)
+    {
+      FlatArray<double> times = time_in_ip ? active_times.Range(first,next)
+        : FlatArray<double>(0,(double*)nullptr);
+      EvaluateAtVertices(ma, st_CF, times, vertex_vals.Rows(first,next), clh);
+      ParallelForRange (Range(nv), [&](IntRange r)
       {
-        coef_tref->SetValue(t+nodes[i]*dt);
-        InterpolateP1 iP1(st_CF, node_gf);
-        iP1.Do(lh);
-        for(int j = 0; j < Vh_ptr->GetNDof();j++)
+        Array<DofId> dofs;
+        for (int vnr : r)
         {
-          gf_vec(i*Vh_ptr->GetNDof()+j) = node_gf_vec(j);
+          Vh->GetDofNrs(NodeId(NT_VERTEX,vnr), dofs);
+          if (dofs.Size() == 0 || dofs[0] == -1)
+            continue;
+          for (int l = first; l < next; l++)
+          {
+            double val = vertex_vals(l,vnr);
+            // avoid vertex cuts by introducing a small perturbation (cf. InterpolateP1)
+            if (abs(val) < 1e-15)
+              val = 1e-15;
+            gf_vec(l*ndof_s + dofs[0]) = val;
+          }
         }
+      });
+    };
+
+    if (coef_tref)
+    {
+      // the time is given by the parameter: one parallel pass per time node.
+      // This path deliberately keeps setting the (global) parameter, st_CF
+      // depends on it and there is no way to pass a different value per
+      // evaluation. Use time=None (reference time in the integration point)
+      // for the single pass without global state.
+      const double backup_tref = coef_tref->GetValue();
+      for (int l = 0; l < active_times.Size(); l++)
+      {
+        coef_tref->SetValue(t+active_times[l]*dt);
+        interpolate(l, l+1, false);
       }
-    }        
-    coef_tref->SetValue(backup_tref);
+      coef_tref->SetValue(backup_tref);
+    }
+    else
+      // the time is passed per evaluation as reference time: one fused pass
+      interpolate(0, active_times.Size(), true);
   }
 
-
-  template void SpaceTimeFESpace :: RestrictGFInTime<double>(shared_ptr<GridFunction>, double, shared_ptr<GridFunction>);
-  template void SpaceTimeFESpace :: RestrictGFInTime<Vec<2>>(shared_ptr<GridFunction>, double, shared_ptr<GridFunction>);
   
 }
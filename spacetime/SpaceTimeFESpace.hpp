@@ -17,6 +17,13 @@
 namespace ngcomp
 {
 
+  /*
+     Tensor product of a spatial FESpace (2D or 3D mesh) and a time element.
+     On 3D meshes only evaluations at a fixed time are supported (SetTime,
+     fix_t), as a 3D integration point has no coordinate left for the time.
+     dt, ReferenceTimeVariable and the space-time cut rules need the time
+     from the point and are restricted to 1D and 2D meshes.
+  */
   class SpaceTimeFESpace : public FESpace
   {
     int ndof;
@@ -71,9 +78,14 @@ namespace ngcomp
       return time_FE->IsNodeActive(i);
     }
 
-    template<typename SCAL>
     void RestrictGFInTime(shared_ptr<GridFunction> st_GF, double time, shared_ptr<GridFunction> s_GF);
+    /// restrict to several times in one sweep over the space-time vector
+    void RestrictGFInTime(shared_ptr<GridFunction> st_GF, FlatArray<double> times, FlatArray<shared_ptr<GridFunction>> s_GFs);
     shared_ptr<GridFunction> CreateRestrictedGF( shared_ptr<GridFunction> st_GF, double time);
+    Array<shared_ptr<GridFunction>> CreateRestrictedGFs( shared_ptr<GridFunction> st_GF, FlatArray<double> times);
+    /// nodal interpolation in time and P1 in space. If tref (a parameter) is given it
+    /// is set to the (absolute) time of the time nodes, otherwise the reference time
+    /// of the nodes is passed in the integration points (cf. ReferenceTimeVariable)
     void InterpolateToP1(shared_ptr<CoefficientFunction> st_CF, shared_ptr<CoefficientFunction> tref, double t, double dt, shared_ptr<GridFunction> st_GF);
 
   };
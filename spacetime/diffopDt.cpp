@@ -7,40 +7,40 @@
 namespace ngfem
 {
 
+  template <int SD>
   template <typename FEL, typename MIP, typename MAT>
-  void DiffOpDt::GenerateMatrix (const FEL & bfel, const MIP & mip,
-                                             MAT & mat, LocalHeap & lh)
+  void DiffOpDt<SD>::GenerateMatrix (const FEL & bfel, const MIP & mip,
+                                     MAT & mat, LocalHeap & lh)
   {
 
-      const SpaceTimeFE & scafe =
-              dynamic_cast<const SpaceTimeFE & > (bfel);
+      const SpaceTimeFE<SD> & scafe =
+              dynamic_cast<const SpaceTimeFE<SD> & > (bfel);
       const int ndof = scafe.GetNDof();
 
       FlatVector<> dtshape (ndof,lh);
-      IntegrationPoint ip(mip.IP());
-      scafe.CalcDtShape(ip,dtshape);
+      scafe.CalcDtShape(mip.IP(),dtshape);
       mat = 0.0;
       mat.Row(0) = dtshape;
 
 
     }
 
-  template class T_DifferentialOperator<DiffOpDt>;
+  template class T_DifferentialOperator<DiffOpDt<2>>;
+  template class T_DifferentialOperator<DiffOpDt<3>>;
 
-  template <int D>
+  template <int SD, int D>
   template <typename FEL, typename MIP, typename MAT>
-  void DiffOpDtVec<D>::GenerateMatrix (const FEL & bfel, const MIP & mip,
-                                             MAT & mat, LocalHeap & lh)
+  void DiffOpDtVec<SD,D>::GenerateMatrix (const FEL & bfel, const MIP & mip,
+                                          MAT & mat, LocalHeap & lh)
   {
 
-      const SpaceTimeFE & scafe =
-              dynamic_cast<const SpaceTimeFE & > (bfel);
+      const SpaceTimeFE<SD> & scafe =
+              dynamic_cast<const SpaceTimeFE<SD> & > (bfel);
       const int ndof = scafe.GetNDof();
 
 
       FlatVector<> dtshape (ndof,lh);
-      IntegrationPoint ip(mip.IP());
-      scafe.CalcDtShape(ip,dtshape);
+      scafe.CalcDtShape(mip.IP(),dtshape);
       mat = 0.0;
 
       for (int j = 0; j < D; j++)
@@ -55,34 +55,39 @@ namespace ngfem
 
     }
 
-  template class T_DifferentialOperator<DiffOpDtVec<1>>;
-  template class T_DifferentialOperator<DiffOpDtVec<2>>;
+  template class T_DifferentialOperator<DiffOpDtVec<2,1>>;
+  template class T_DifferentialOperator<DiffOpDtVec<2,2>>;
+  template class T_DifferentialOperator<DiffOpDtVec<3,1>>;
+  template class T_DifferentialOperator<DiffOpDtVec<3,2>>;
+  template class T_DifferentialOperator<DiffOpDtVec<3,3>>;
 
 
-  template <int time>
+  template <int SD, int time>
   template <typename FEL, typename MIP, typename MAT>
-  void DiffOpFixt<time>::GenerateMatrix (const FEL & bfel, const MIP & mip,
-                                             MAT & mat, LocalHeap & lh)
+  void DiffOpFixt<SD,time>::GenerateMatrix (const FEL & bfel, const MIP & mip,
+                                            MAT & mat, LocalHeap & lh)
   {
 
-      const SpaceTimeFE & scafe =
-              dynamic_cast<const SpaceTimeFE & > (bfel);
+      const SpaceTimeFE<SD> & scafe =
+              dynamic_cast<const SpaceTimeFE<SD> & > (bfel);
       const int ndof = scafe.GetNDof();
 
       FlatVector<> shape (ndof,lh);
-      IntegrationPoint ip(mip.IP()(0),mip.IP()(1),time);
-      scafe.CalcShape(ip,shape);
+      scafe.CalcShape(mip.IP(),double(time),shape);
       mat = 0.0;
       mat.Row(0) = shape;
 
 
    }
 
-  template class T_DifferentialOperator<DiffOpFixt<0>>;
-  template class T_DifferentialOperator<DiffOpFixt<1>>;
+  template class T_DifferentialOperator<DiffOpFixt<2,0>>;
+  template class T_DifferentialOperator<DiffOpFixt<2,1>>;
+  template class T_DifferentialOperator<DiffOpFixt<3,0>>;
+  template class T_DifferentialOperator<DiffOpFixt<3,1>>;
 
 
-  void DiffOpFixAnyTime ::
+  template <int SD>
+  void DiffOpFixAnyTime<SD> ::
   CalcMatrix (const FiniteElement & bfel,
               const BaseMappedIntegrationPoint & bmip,
               SliceMatrix<double,ColMajor> mat,
@@ -91,18 +96,18 @@ namespace ngfem
     const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE> & mip =
       static_cast<const MappedIntegrationPoint<DIM_ELEMENT,DIM_SPACE>&> (bmip);
 
-    const SpaceTimeFE & scafe =
-            dynamic_cast<const SpaceTimeFE & > (bfel);
+    const SpaceTimeFE<SD> & scafe =
+            dynamic_cast<const SpaceTimeFE<SD> & > (bfel);
     const int ndof = scafe.GetNDof();
 
     FlatVector<> shape (ndof,lh);
-    IntegrationPoint ip(mip.IP()(0),mip.IP()(1),time);
-    scafe.CalcShape(ip,shape);
+    scafe.CalcShape(mip.IP(),time,shape);
     mat = 0.0;
     mat.Row(0) = shape;
   }
 
-  void DiffOpFixAnyTime ::
+  template <int SD>
+  void DiffOpFixAnyTime<SD> ::
   ApplyTrans (const FiniteElement & fel,
               const BaseMappedIntegrationPoint & mip,
               FlatVector<double> flux,
@@ -115,7 +120,8 @@ namespace ngfem
     x = Trans(mat) * flux;
   }
 
-
+  template class DiffOpFixAnyTime<2>;
+  template class DiffOpFixAnyTime<3>;
 
 }
 
@@ -7,13 +7,14 @@
 namespace ngfem
 {
 
-  class DiffOpDt : public DiffOp<DiffOpDt>
+  template <int SD>
+  class DiffOpDt : public DiffOp<DiffOpDt<SD>>
   {
 
   public:
     enum { DIM = 1 };          // just one copy of the spaces
-    enum { DIM_SPACE = 2 };    // D-dim space
-    enum { DIM_ELEMENT = 2 };  // D-dim elements (in contrast to boundary elements)
+    enum { DIM_SPACE = SD };   // SD-dim space
+    enum { DIM_ELEMENT = SD }; // SD-dim elements (in contrast to boundary elements)
     enum { DIM_DMAT = 1 };     // D-matrix
     enum { DIFFORDER = 0 };    // minimal differential order (to determine integration order)
 
@@ -22,14 +23,14 @@ namespace ngfem
                                 MAT & mat, LocalHeap & lh);
   };
 
-  template <int D>
-  class DiffOpDtVec : public DiffOp<DiffOpDtVec<D>>
+  template <int SD, int D>
+  class DiffOpDtVec : public DiffOp<DiffOpDtVec<SD,D>>
   {
 
   public:
-    enum { DIM = D };          // two copies of the spaces
-    enum { DIM_SPACE = 2 };    // D-dim space
-    enum { DIM_ELEMENT = 2 };  // D-dim elements (in contrast to boundary elements)
+    enum { DIM = D };          // D copies of the spaces
+    enum { DIM_SPACE = SD };   // SD-dim space
+    enum { DIM_ELEMENT = SD }; // SD-dim elements (in contrast to boundary elements)
     enum { DIM_DMAT = D };     // D-matrix
     enum { DIFFORDER = 0 };    // minimal differential order (to determine integration order)
 
@@ -39,14 +40,14 @@ namespace ngfem
   };
 
 
-  template <int time>
-  class DiffOpFixt : public DiffOp<DiffOpFixt<time>>
+  template <int SD, int time>
+  class DiffOpFixt : public DiffOp<DiffOpFixt<SD,time>>
   {
 
   public:
     enum { DIM = 1 };          // just one copy of the spaces
-    enum { DIM_SPACE = 2 };    // D-dim space
-    enum { DIM_ELEMENT = 2 };  // D-dim elements (in contrast to boundary elements)
+    enum { DIM_SPACE = SD };   // SD-dim space
+    enum { DIM_ELEMENT = SD }; // SD-dim elements (in contrast to boundary elements)
     enum { DIM_DMAT = 1 };     // D-matrix
     enum { DIFFORDER = 0 };    // minimal differential order (to determine integration order)
 
@@ -57,6 +58,7 @@ namespace ngfem
 
 
 
+  template <int SD>
   class DiffOpFixAnyTime : public DifferentialOperator
   {
     double time;
@@ -64,8 +66,8 @@ namespace ngfem
   public:
 
     enum { DIM = 1 };          // just one copy of the spaces
-    enum { DIM_SPACE = 2 };    // D-dim space
-    enum { DIM_ELEMENT = 2 };  // D-dim elements (in contrast to boundary elements)
+    enum { DIM_SPACE = SD };   // SD-dim space
+    enum { DIM_ELEMENT = SD }; // SD-dim elements (in contrast to boundary elements)
     enum { DIM_DMAT = 1 };     // D-matrix
     enum { DIFFORDER = 0 };    // minimal differential order (to determine integration order)
 
@@ -105,11 +107,19 @@ namespace ngfem
 
 
 #ifndef FILE_DIFFOPDT_CPP
-  extern template class T_DifferentialOperator<DiffOpDt>;
-  extern template class T_DifferentialOperator<DiffOpDtVec<1>>;
-  extern template class T_DifferentialOperator<DiffOpDtVec<2>>;
-  extern template class T_DifferentialOperator<DiffOpFixt<0>>;
-  extern template class T_DifferentialOperator<DiffOpFixt<1>>;
+  extern template class T_DifferentialOperator<DiffOpDt<2>>;
+  extern template class T_DifferentialOperator<DiffOpDt<3>>;
+  extern template class T_DifferentialOperator<DiffOpDtVec<2,1>>;
+  extern template class T_DifferentialOperator<DiffOpDtVec<2,2>>;
+  extern template class T_DifferentialOperator<DiffOpDtVec<3,1>>;
+  extern template class T_DifferentialOperator<DiffOpDtVec<3,2>>;
+  extern template class T_DifferentialOperator<DiffOpDtVec<3,3>>;
+  extern template class T_DifferentialOperator<DiffOpFixt<2,0>>;
+  extern template class T_DifferentialOperator<DiffOpFixt<2,1>>;
+  extern template class T_DifferentialOperator<DiffOpFixt<3,0>>;
+  extern template class T_DifferentialOperator<DiffOpFixt<3,1>>;
+  extern template class DiffOpFixAnyTime<2>;
+  extern template class DiffOpFixAnyTime<3>;
 #endif
 
 }
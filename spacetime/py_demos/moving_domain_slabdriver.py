@@ -0,0 +1,142 @@
+# Unfitted heat equation on the moving domain of py_tutorials/moving_domain.py
+# solved with a P1-DG-in-time space-time discretization.
+#
+# The time loop is run twice:
+#  * reference loop: interpolation of the level set, CutInfo update,
+#                    assembly and solve one after the other
+#  * driver loop:    the SpaceTimeSlabDriver solves the system of the
+#                    current slab and prepares the geometry of the next one
+#                    while the umfpack factorization runs on its own thread
+# Both loops give the same discrete solution, the timings are printed.
+#
+# usage: python3 moving_domain_slabdriver.py [testmode]
+
+import sys
+from time import time as wallclock
+from ngsolve import *
+from netgen.geom2d import SplineGeometry
+from xfem import *
+from math import pi
+
+testmode = hasattr(sys, 'argv') and len(sys.argv) > 1 and sys.argv[1] == "testmode"
+
+ngsglobals.msg_level = 0
+
+square = SplineGeometry()
+square.AddRectangle([-1,-0.75],[1,1.5])
+maxh = 0.2 if testmode else 0.05
+mesh = Mesh (square.GenerateMesh(maxh=maxh, quad_dominated=False))
+
+coef_told = Parameter(0)
+coef_delta_t = Parameter(0)
+tref = ReferenceTimeVariable()
+t = coef_told + coef_delta_t*tref
+
+# geometry and data as in py_tutorials/moving_domain.py
+r0 = 0.5
+r1 = 0.5*pi/r0
+rho =  CoefficientFunction((1/(pi))*sin(2*pi*t))
+d_rho = CoefficientFunction(2*cos(2*pi*t))
+w = CoefficientFunction((0,d_rho))
+r = sqrt(x*x+(y-rho)*(y-rho))
+levelset = r - r0
+coeff_f = CoefficientFunction(-(pi/r0)*r1*( sin(r1*r)*sin(r1*r) - cos(r1*r)*cos(r1*r) )
+                              + (pi/r0)*cos(r1*r)*sin(r1*r)*(1/r))
+u_exact = cos(r1*r)*cos(r1*r)
+
+k_t = 1
+k_s = 1
+time_order = 2
+tend = 0.5
+delta_t = tend/4 if testmode else tend/32
+coef_delta_t.Set(delta_t)
+
+fes1 = H1(mesh, order=k_s)
+tfe = ScalarTimeFE(k_t)
+st_fes = SpaceTimeFESpace(fes1,tfe, flags = {"dgjumps": True})
+
+def TimeLoop(use_driver):
+    lset_p1 = GridFunction(st_fes)
+    lset_top = GridFunction(fes1)
+    lset_bottom = GridFunction(fes1)
+    gfu = GridFunction(st_fes)
+    u_last = CreateTimeRestrictedGF(gfu,0)
+    coef_told.Set(0)
+    u_last.Set(u_exact)
+
+    u,v = st_fes.TnT()
+    h = specialcf.mesh_size
+
+    lset_neg = { "levelset" : lset_p1, "domain_type" : NEG, "subdivlvl" : 0}
+    lset_neg_bottom = { "levelset" : lset_bottom, "domain_type" : NEG, "subdivlvl" : 0}
+    lset_neg_top = { "levelset" : lset_top, "domain_type" : NEG, "subdivlvl" : 0}
+
+    def SpaceTimeNegBFI(form):
+        return SymbolicBFI(levelset_domain = lset_neg, form = form, time_order=time_order)
+
+    ci = CutInfo(mesh,time_order=time_order)
+
+    hasneg_integrators_a = []
+    hasneg_integrators_f = []
+    patch_integrators_a = []
+    hasneg_integrators_a.append(SpaceTimeNegBFI(form = delta_t*grad(u)*grad(v)))
+    hasneg_integrators_a.append(SymbolicBFI(levelset_domain = lset_neg_top, form = fix_t(u,1)*fix_t(v,1)))
+    hasneg_integrators_a.append(SpaceTimeNegBFI(form = -u*dt(v)))
+    hasneg_integrators_a.append(SpaceTimeNegBFI(form = -delta_t*u*InnerProduct(w,grad(v))))
+    patch_integrators_a.append(SymbolicFacetPatchBFI(form = delta_t*1.05*h**(-2)*(u-u.Other())*(v-v.Other()),
+                                                     skeleton=False, time_order=time_order))
+    hasneg_integrators_f.append(SymbolicLFI(levelset_domain = lset_neg, form = delta_t*coeff_f*v, time_order=time_order))
+    hasneg_integrators_f.append(SymbolicLFI(levelset_domain = lset_neg_bottom,form = u_last*fix_t(v,0)))
+
+    a = BilinearForm(st_fes,check_unused=False,symmetric=False)
+    for integrator in hasneg_integrators_a + patch_integrators_a:
+        a += integrator
+    f = LinearForm(st_fes)
+    for integrator in hasneg_integrators_f:
+        f += integrator
+
+    if use_driver:
+        driver = SpaceTimeSlabDriver(lset_p1, ci, levelset, coef_told, delta_t, time_order=time_order)
+        driver.Prepare(0.0)
+
+    told = 0
+    l2error = 0
+    tstart = wallclock()
+    while tend - told > delta_t/2:
+        if not use_driver:
+            SpaceTimeInterpolateToP1(levelset,coef_told,told,delta_t,lset_p1)
+            ci.Update(lset_p1,time_order=time_order)
+        RestrictGFInTime(spacetime_gf=lset_p1,reference_time=0.0,space_gf=lset_bottom)
+        RestrictGFInTime(spacetime_gf=lset_p1,reference_time=1.0,space_gf=lset_top)
+
+        ba_facets = GetFacetsWithNeighborTypes(mesh,a=ci.GetElementsOfType(HASNEG),
+                                                    b=ci.GetElementsOfType(IF))
+        active_dofs = GetDofsOfElements(st_fes,ci.GetElementsOfType(HASNEG))
+        for integrator in hasneg_integrators_a + hasneg_integrators_f:
+            integrator.SetDefinedOnElements(ci.GetElementsOfType(HASNEG))
+        for integrator in patch_integrators_a:
+            integrator.SetDefinedOnElements(ba_facets)
+
+        a.Assemble()
+        f.Assemble()
+
+        gfu.vec[:] = 0
+        if use_driver:
+            driver.Step(a.mat, f.vec, gfu.vec, freedofs=active_dofs, inverse="umfpack")
+        else:
+            gfu.vec.data = a.mat.Inverse(active_dofs,inverse="umfpack") * f.vec
+
+        RestrictGFInTime(spacetime_gf=gfu,reference_time=1.0,space_gf=u_last)
+        told = told + delta_t
+        coef_told.Set(told)
+        l2error = sqrt(Integrate(lset_neg_top,(u_exact-u_last)*(u_exact-u_last),mesh))
+    return l2error, wallclock()-tstart
+
+with TaskManager():
+    err_ref, time_ref = TimeLoop(use_driver=False)
+    err_drv, time_drv = TimeLoop(use_driver=True)
+
+print("reference loop: l2error = {0:12.6e}, time = {1:8.3f}s".format(err_ref,time_ref))
+print("driver loop:    l2error = {0:12.6e}, time = {1:8.3f}s".format(err_drv,time_drv))
+
+assert abs(err_ref - err_drv) < 1e-10 * max(1,err_ref)
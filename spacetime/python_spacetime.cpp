@@ -22,10 +22,63 @@
 #include "../spacetime/SpaceTimeFESpace.hpp"
 #include "../spacetime/diffopDt.hpp"
 #include "../spacetime/timecf.hpp"
+#include "../spacetime/slabdriver.hpp"
 
 using namespace ngcomp;
 using namespace xintegration;
 
+// the space-time diffops are templated on the spatial dimension of the mesh
+template <int SD>
+shared_ptr<DifferentialOperator> CreateDiffOpDt (int vdim = 0)
+{
+  switch (vdim)
+  {
+    case 0 : return make_shared<T_DifferentialOperator<DiffOpDt<SD>>> ();
+    case 1 : return make_shared<T_DifferentialOperator<DiffOpDtVec<SD,1>>> ();
+    case 2 : return make_shared<T_DifferentialOperator<DiffOpDtVec<SD,2>>> ();
+    case 3 :
+      if (SD == 3)
+        return make_shared<T_DifferentialOperator<DiffOpDtVec<3,3>>> ();
+      break;
+    default : break;
+  }
+  throw Exception("Diffop dt only implemented for dim <= space dimension so far.");
+}
+
+shared_ptr<DifferentialOperator> CreateDiffOpDt (shared_ptr<FESpace> fes, int vdim = 0)
+{
+  if (fes->GetMeshAccess()->GetDimension() == 3)
+    return CreateDiffOpDt<3>(vdim);
+  else
+    return CreateDiffOpDt<2>(vdim);
+}
+
+template <int SD>
+shared_ptr<DifferentialOperator> CreateDiffOpFixt (double time, bool use_FixAnyTime)
+{
+  if(!use_FixAnyTime && (time == 0.0 || time == 1.0))
+  {
+    switch (int(time))
+    {
+      case 0 : return make_shared<T_DifferentialOperator<DiffOpFixt<SD,0>>> ();
+      case 1 : return make_shared<T_DifferentialOperator<DiffOpFixt<SD,1>>> ();
+      default : throw Exception("Requested time not implemented yet.");
+    }
+  }
+  else {
+    cout << IM(3) << "Calling DiffOpFixAnyTime" << endl;
+    return make_shared<DiffOpFixAnyTime<SD>> (time);
+  }
+}
+
+shared_ptr<DifferentialOperator> CreateDiffOpFixt (shared_ptr<FESpace> fes, double time, bool use_FixAnyTime)
+{
+  if (fes->GetMeshAccess()->GetDimension() == 3)
+    return CreateDiffOpFixt<3>(time, use_FixAnyTime);
+  else
+    return CreateDiffOpFixt<2>(time, use_FixAnyTime);
+}
+
 void ExportNgsx_spacetime(py::module &m)
 {
 
@@ -164,7 +217,7 @@ void ExportNgsx_spacetime(py::module &m)
     }
 
     shared_ptr<DifferentialOperator> diffopdt;
-    diffopdt = make_shared<T_DifferentialOperator<DiffOpDt>> ();
+    diffopdt = CreateDiffOpDt(self->GetFESpace());
 
     for (int i = comparr.Size() - 1; i >= 0; --i)
     {
@@ -185,7 +238,7 @@ void ExportNgsx_spacetime(py::module &m)
   m.def("dt", [](PyGF self) -> PyCF
   {
     shared_ptr<DifferentialOperator> diffopdt;
-    diffopdt = make_shared<T_DifferentialOperator<DiffOpDt>> ();
+    diffopdt = CreateDiffOpDt(self->GetFESpace());
 
     return PyCF(make_shared<GridFunctionCoefficientFunction> (self, diffopdt));
   });
@@ -220,13 +273,7 @@ void ExportNgsx_spacetime(py::module &m)
      }
 
      shared_ptr<DifferentialOperator> diffopdtvec;
-
-     switch (self->Dimension())
-     {
-       case 1 : diffopdtvec = make_shared<T_DifferentialOperator<DiffOpDtVec<1>>> (); break;
-       case 2 : diffopdtvec = make_shared<T_DifferentialOperator<DiffOpDtVec<2>>> (); break;
-       default : throw Exception("Diffop dt only implemented for dim <= 2 so far.");
-     }
+     diffopdtvec = CreateDiffOpDt(self->GetFESpace(), self->Dimension());
 
      for (int i = comparr.Size() - 1; i >= 0; --i)
      {
@@ -247,13 +294,7 @@ void ExportNgsx_spacetime(py::module &m)
    m.def("dt_vec", [](PyGF self) -> PyCF
    {
      shared_ptr<DifferentialOperator> diffopdtvec;
-
-     switch (self->Dimension())
-     {
-       case 1 : diffopdtvec = make_shared<T_DifferentialOperator<DiffOpDtVec<1>>> (); break;
-       case 2 : diffopdtvec = make_shared<T_DifferentialOperator<DiffOpDtVec<2>>> (); break;
-       default : throw Exception("Diffop dt only implemented for dim <= 2 so far.");
-     }
+     diffopdtvec = CreateDiffOpDt(self->GetFESpace(), self->Dimension());
 
      return PyCF(make_shared<GridFunctionCoefficientFunction> (self, diffopdtvec,nullptr,nullptr,0));
    });
@@ -290,19 +331,7 @@ void ExportNgsx_spacetime(py::module &m)
 
     shared_ptr<DifferentialOperator> diffopfixt;
 
-    if(!use_FixAnyTime && (time == 0.0 || time == 1.0))
-    {
-      switch (int(time))
-      {
-        case 0 : diffopfixt = make_shared<T_DifferentialOperator<DiffOpFixt<0>>> (); break;
-        case 1 : diffopfixt = make_shared<T_DifferentialOperator<DiffOpFixt<1>>> (); break;
-        default : throw Exception("Requested time not implemented yet.");
-      }
-    }
-    else {
-      cout << "Calling DiffOpFixAnyTime" << endl;
-      diffopfixt = make_shared<DiffOpFixAnyTime> (time);
-    }
+    diffopfixt = CreateDiffOpFixt(self->GetFESpace(), time, use_FixAnyTime);
 
 
     for (int i = comparr.Size() - 1; i >= 0; --i)
@@ -327,19 +356,7 @@ void ExportNgsx_spacetime(py::module &m)
    {
      shared_ptr<DifferentialOperator> diffopfixt;
 
-     if(!use_FixAnyTime && (time == 0.0 || time == 1.0))
-     {
-       switch (int(time))
-       {
-         case 0 : diffopfixt = make_shared<T_DifferentialOperator<DiffOpFixt<0>>> (); break;
-         case 1 : diffopfixt = make_shared<T_DifferentialOperator<DiffOpFixt<1>>> (); break;
-         default : throw Exception("Requested time not implemented yet.");
-       }
-     }
-     else {
-       cout << "Calling DiffOpFixAnyTime" << endl;
-       diffopfixt = make_shared<DiffOpFixAnyTime> (time);
-     }
+     diffopfixt = CreateDiffOpFixt(self->GetFESpace(), time, use_FixAnyTime);
 
 
      return PyCF(make_shared<GridFunctionCoefficientFunction> (self, diffopfixt));
@@ -360,41 +377,174 @@ void ExportNgsx_spacetime(py::module &m)
    py::arg("reference_time") = 0.0,
    "Create spatial-only Gridfunction corresponding to a fixed time.");
 
+   m.def("CreateTimeRestrictedGF", [](PyGF st_GF, py::list times) -> py::list
+   {
+     FESpace* raw_FE = (st_GF->GetFESpace()).get();
+     SpaceTimeFESpace * st_FES = dynamic_cast<SpaceTimeFESpace*>(raw_FE);
+     Array<double> atimes = makeCArray<double> (times);
+     auto s_GFs = st_FES->CreateRestrictedGFs(st_GF,atimes);
+     py::list ret;
+     for (auto gf : s_GFs)
+       ret.append(py::cast(gf));
+     return ret;
+   },
+   py::arg("gf"),
+   py::arg("reference_times"),
+   "Create spatial-only Gridfunctions corresponding to a list of fixed times (one sweep over the space-time vector).");
+
    m.def("RestrictGFInTime", [](PyGF st_GF,double time,PyGF s_GF)
    {
      FESpace* raw_FE = (st_GF->GetFESpace()).get();
      SpaceTimeFESpace * st_FES = dynamic_cast<SpaceTimeFESpace*>(raw_FE);
-     switch (st_FES->GetDimension())
-     {
-       case 1:
-         st_FES->RestrictGFInTime<double>(st_GF,time,s_GF);
-         break;
-       case 2:
-         st_FES->RestrictGFInTime<Vec<2>>(st_GF,time,s_GF);
-         break;
-       default:
-         throw Exception("cannot handle GridFunction type (dimension too large?).");
-         break;
-     }
+     st_FES->RestrictGFInTime(st_GF,time,s_GF);
    }, 
    py::arg("spacetime_gf"),
    py::arg("reference_time") = 0.0,
    py::arg("space_gf"),
    "Extract Gridfunction corresponding to a fixed time from a space-time GridFunction.");
 
-   m.def("SpaceTimeInterpolateToP1", [](PyCF st_CF, PyCF tref, double t, double dt, PyGF st_GF)
+   m.def("RestrictGFInTime", [](PyGF st_GF, py::list times, py::list s_GFs)
+   {
+     FESpace* raw_FE = (st_GF->GetFESpace()).get();
+     SpaceTimeFESpace * st_FES = dynamic_cast<SpaceTimeFESpace*>(raw_FE);
+     Array<double> atimes = makeCArray<double> (times);
+     Array<PyGF> agfs = makeCArray<PyGF> (s_GFs);
+     st_FES->RestrictGFInTime(st_GF,atimes,agfs);
+   },
+   py::arg("spacetime_gf"),
+   py::arg("reference_times"),
+   py::arg("space_gfs"),
+   "Extract Gridfunctions corresponding to a list of fixed times from a space-time GridFunction (one sweep over the space-time vector).");
+
+   m.def("SpaceTimeInterpolateToP1", [](PyCF st_CF, py::object tref, double t, double dt, PyGF st_GF)
    {
      FESpace* raw_FE = (st_GF->GetFESpace()).get();
      SpaceTimeFESpace * st_FES = dynamic_cast<SpaceTimeFESpace*>(raw_FE);
      if (!st_FES) throw Exception("not a spacetime gridfunction");
-     st_FES->InterpolateToP1(st_CF,tref,t,dt,st_GF);
+     PyCF cftref = nullptr;
+     if (py::extract<PyCF> (tref).check())
+       cftref = py::extract<PyCF>(tref)();
+     st_FES->InterpolateToP1(st_CF,cftref,t,dt,st_GF);
    }, 
    py::arg("spacetime_cf"),
-   py::arg("time"),
-   py::arg("tstart"),
-   py::arg("dt"),
+   py::arg("time") = DummyArgument(),
+   py::arg("tstart") = 0.0,
+   py::arg("dt") = 1.0,
    py::arg("spacetime_gf"),
-   "Interpolate nodal in time (possible high order) and nodal in space (P1).");
+   docu_string(R"raw_string(
+Interpolate nodal in time (possible high order) and nodal in space (P1).
+
+Parameters
+
+spacetime_cf : ngsolve.CoefficientFunction
+  function to interpolate
+
+time : ngsolve.Parameter / None
+  if given, the parameter is set to tstart + dt * t_i for the time nodes t_i (and reset
+  afterwards). If None, the time nodes t_i are passed per evaluation as reference time
+  (ReferenceTimeVariable) and no global state is changed (2D only).
+
+tstart : float
+  start of the time slab (only used with time)
+
+dt : float
+  size of the time slab (only used with time)
+
+spacetime_gf : ngsolve.GridFunction
+  space-time GridFunction (P1 in space) for the result
+)raw_string"));
+
+   py::class_<SpaceTimeSlabDriver, shared_ptr<SpaceTimeSlabDriver>>
+     (m, "SpaceTimeSlabDriver", R"raw(
+Driver for time slab loops of space-time cut discretizations. A step solves the
+linear system of the current slab and prepares the geometry of the next slab
+(nodal interpolation of the level set into the space-time P1 space and the
+update of the CutInfo). For external direct solvers (umfpack, pardiso, superlu)
+the factorization runs on a separate thread while the geometry work uses the
+TaskManager, otherwise both parts run one after the other.
+)raw")
+    .def("__init__", [] (SpaceTimeSlabDriver *instance,
+                         PyGF lset_p1, shared_ptr<CutInformation> cutinfo,
+                         PyCF levelset, PyCF told, double dt, int time_order, int heapsize)
+         {
+           new (instance) SpaceTimeSlabDriver (lset_p1, cutinfo, levelset, told, dt, time_order, heapsize);
+         },
+         py::arg("lset_p1"),
+         py::arg("cutinfo"),
+         py::arg("levelset"),
+         py::arg("told"),
+         py::arg("dt"),
+         py::arg("time_order") = -1,
+         py::arg("heapsize") = 1000000, docu_string(R"raw_string(
+Creates a slab driver.
+
+Parameters
+
+lset_p1 : ngsolve.GridFunction
+  space-time P1 GridFunction that carries the level set of the current slab
+  (used in the forms)
+
+cutinfo : xfem.CutInfo
+  CutInfo of the current slab (used for markers)
+
+levelset : ngsolve.CoefficientFunction
+  level set function (depending on told)
+
+told : ngsolve.Parameter
+  time parameter that is set during the interpolation (cf. SpaceTimeInterpolateToP1)
+
+dt : float
+  time step
+
+time_order : int
+  order in time for the CutInfo update
+)raw_string"))
+    .def("Prepare", [] (SpaceTimeSlabDriver & self, double t0)
+         {
+           self.Prepare(t0);
+         },
+         py::arg("tstart"),
+         "Interpolate the level set and update the CutInfo for the slab starting at tstart.")
+    .def("Step", [] (SpaceTimeSlabDriver & self, shared_ptr<BaseMatrix> mat,
+                     shared_ptr<BaseVector> rhs, shared_ptr<BaseVector> sol,
+                     py::object freedofs, string inverse)
+         {
+           PyBA fd = nullptr;
+           if (py::extract<PyBA> (freedofs).check())
+             fd = py::extract<PyBA>(freedofs)();
+           self.Step(mat, fd, inverse, rhs, sol);
+         },
+         py::arg("mat"),
+         py::arg("rhs"),
+         py::arg("sol"),
+         py::arg("freedofs") = DummyArgument(),
+         py::arg("inverse") = "", docu_string(R"raw_string(
+Solves the system of the current slab and prepares the geometry of the next slab.
+Afterwards lset_p1 and cutinfo describe the next slab. The system
+has to be assembled before as the time parameter is changed during the step.
+
+Parameters
+
+mat : ngsolve.BaseMatrix
+  (assembled) system matrix of the current slab
+
+rhs : ngsolve.BaseVector
+  right hand side
+
+sol : ngsolve.BaseVector
+  solution vector (Dirichlet values on entry)
+
+freedofs : ngsolve.BitArray
+  free dofs for the inverse
+
+inverse : str
+  inverse type (e.g. "umfpack", "pardiso"), default of the matrix if empty. The
+  inverse type of mat is restored after the factorization.
+)raw_string"))
+    .def_property_readonly("time", &SpaceTimeSlabDriver::GetTime, "start time of the current slab")
+    .def_property_readonly("levelset", &SpaceTimeSlabDriver::GetLevelset, "level set GridFunction of the current slab")
+    .def_property_readonly("cutinfo", &SpaceTimeSlabDriver::GetCutInfo, "CutInfo of the current slab")
+    ;
 
 }
 
@@ -0,0 +1,107 @@
+#include "slabdriver.hpp"
+#include <future>
+
+namespace ngcomp
+{
+
+  SpaceTimeSlabDriver :: SpaceTimeSlabDriver (shared_ptr<GridFunction> alset_p1,
+                                              shared_ptr<CutInformation> acutinfo,
+                                              shared_ptr<CoefficientFunction> alset_cf,
+                                              shared_ptr<CoefficientFunction> acoef_told,
+                                              double adt, int atime_order, size_t aheapsize)
+    : lset_p1(alset_p1), cutinfo(acutinfo), lset_cf(alset_cf), coef_told(acoef_told),
+      dt(adt), time_order(atime_order), heapsize(aheapsize)
+  {
+    auto st_fes = dynamic_pointer_cast<SpaceTimeFESpace>(lset_p1->GetFESpace());
+    if (!st_fes)
+      throw Exception("SpaceTimeSlabDriver: level set is not a space-time GridFunction");
+  }
+
+  void SpaceTimeSlabDriver :: PrepareGeometry (double t0, shared_ptr<GridFunction> gf,
+                                               shared_ptr<CutInformation> ci)
+  {
+    static Timer timer ("SpaceTimeSlabDriver::PrepareGeometry");
+    RegionTimer reg (timer);
+    auto st_fes = dynamic_pointer_cast<SpaceTimeFESpace>(gf->GetFESpace());
+    st_fes->InterpolateToP1(lset_cf, coef_told, t0, dt, gf);
+    LocalHeap lh (heapsize, "SpaceTimeSlabDriver-heap", true);
+    ci->Update(gf, time_order, lh);
+  }
+
+  void SpaceTimeSlabDriver :: Solve (shared_ptr<BaseMatrix> mat, shared_ptr<BaseMatrix> inv,
+                                     shared_ptr<BaseVector> rhs, shared_ptr<BaseVector> sol)
+  {
+    static Timer timer ("SpaceTimeSlabDriver::Solve");
+    RegionTimer reg (timer);
+    // homogenize: sol holds the Dirichlet values
+    shared_ptr<BaseVector> res = rhs->CreateVector();
+    res->Set(1.0, *rhs);
+    mat->MultAdd(-1.0, *sol, *res);
+    inv->MultAdd(1.0, *res, *sol);
+  }
+
+  void SpaceTimeSlabDriver :: Prepare (double t0)
+  {
+    tcur = t0;
+    PrepareGeometry(t0, lset_p1, cutinfo);
+  }
+
+  void SpaceTimeSlabDriver :: Step (shared_ptr<BaseMatrix> mat, shared_ptr<BitArray> freedofs,
+                                    string inverse, shared_ptr<BaseVector> rhs,
+                                    shared_ptr<BaseVector> sol)
+  {
+    static Timer timer ("SpaceTimeSlabDriver::Step");
+    static Timer timer_overlap ("SpaceTimeSlabDriver::Step - factorization || geometry");
+    RegionTimer reg (timer);
+    const double tnext = tcur + dt;
+
+    // the inverse type is set on mat for the factorization and restored afterwards
+    auto spmat = dynamic_pointer_cast<BaseSparseMatrix>(mat);
+    if (inverse != "" && !spmat)
+      throw Exception("SpaceTimeSlabDriver: inverse type can only be set for sparse matrices");
+    INVERSETYPE old_inverse = SPARSECHOLESKY;
+    if (spmat)
+    {
+      old_inverse = spmat->GetInverseType();
+      if (inverse != "")
+        spmat->SetInverseType(inverse);
+    }
+
+    // external direct solvers do not use the task manager, their factorization runs
+    // on a separate thread while the geometry of the next slab is prepared with the
+    // parallel loops of the task manager. The geometry only enters the next
+    // assembly, the matrix and vectors of the current slab are not touched by it.
+    const INVERSETYPE invtype = spmat ? spmat->GetInverseType() : SPARSECHOLESKY;
+    const bool overlap = spmat && (invtype == UMFPACK || invtype == PARDISO
+                                   || invtype == PARDISOSPD || invtype == SUPERLU);
+    shared_ptr<BaseMatrix> inv;
+    try
+    {
+      if (overlap)
+      {
+        RegionTimer rego (timer_overlap);
+        // (the future waits for the factorization if PrepareGeometry throws)
+        auto factorization = std::async(std::launch::async,
+                                        [mat, freedofs] () { return mat->InverseMatrix(freedofs); });
+        PrepareGeometry(tnext, lset_p1, cutinfo);
+        inv = factorization.get();
+      }
+      else
+      {
+        inv = mat->InverseMatrix(freedofs);
+        PrepareGeometry(tnext, lset_p1, cutinfo);
+      }
+    }
+    catch (...)
+    {
+      if (spmat) spmat->SetInverseType(old_inverse);
+      throw;
+    }
+    if (spmat)
+      spmat->SetInverseType(old_inverse);
+
+    Solve(mat, inv, rhs, sol);
+    tcur = tnext;
+  }
+
+}
@@ -0,0 +1,67 @@
+#ifndef FILE_SLABDRIVER_HPP
+#define FILE_SLABDRIVER_HPP
+
+#include <comp.hpp>
+#include "SpaceTimeFESpace.hpp"
+#include "../xfem/cutinfo.hpp"
+
+namespace ngcomp
+{
+
+  /*
+     Driver for a sequence of space-time slabs [t_n, t_n + dt].
+
+     The geometry work of a slab (nodal interpolation of the level set into
+     the space-time P1 space, classification of elements by CutInformation)
+     only depends on the level set function. A step factorizes the matrix of
+     slab n and prepares the geometry of slab n+1 in the level set
+     GridFunction and CutInformation that the user's forms are set up with.
+     For external direct solvers (umfpack, pardiso, superlu) the
+     factorization runs on its own thread while the geometry work uses the
+     parallel loops of the task manager, otherwise both parts run one after
+     the other.
+
+     The time parameter (told) is set during the interpolation and the
+     geometry of slab n is overwritten, so slab n has to be assembled before
+     the next step is started.
+  */
+  class SpaceTimeSlabDriver
+  {
+    shared_ptr<GridFunction> lset_p1;         // level set of the current slab
+    shared_ptr<CutInformation> cutinfo;       // cut information of the current slab
+    shared_ptr<CoefficientFunction> lset_cf;
+    shared_ptr<CoefficientFunction> coef_told;
+    double dt;
+    int time_order;
+    size_t heapsize;
+    double tcur = 0.0;
+
+    /// interpolation and classification for the slab starting at t0
+    void PrepareGeometry (double t0, shared_ptr<GridFunction> gf, shared_ptr<CutInformation> ci);
+    /// solve with the factorization inv, sol contains the Dirichlet values on entry
+    void Solve (shared_ptr<BaseMatrix> mat, shared_ptr<BaseMatrix> inv,
+                shared_ptr<BaseVector> rhs, shared_ptr<BaseVector> sol);
+  public:
+    SpaceTimeSlabDriver (shared_ptr<GridFunction> alset_p1,
+                         shared_ptr<CutInformation> acutinfo,
+                         shared_ptr<CoefficientFunction> alset_cf,
+                         shared_ptr<CoefficientFunction> acoef_told,
+                         double adt, int atime_order, size_t aheapsize = 1000000);
+
+    /// sequential preparation of the (first) slab starting at t0
+    void Prepare (double t0);
+
+    /// solve the system of the current slab and prepare the next slab
+    /// [t+dt, t+2dt] (overlapping with the factorization if possible),
+    /// afterwards the next slab is current
+    void Step (shared_ptr<BaseMatrix> mat, shared_ptr<BitArray> freedofs, string inverse,
+               shared_ptr<BaseVector> rhs, shared_ptr<BaseVector> sol);
+
+    double GetTime () const { return tcur; }
+    shared_ptr<GridFunction> GetLevelset () const { return lset_p1; }
+    shared_ptr<CutInformation> GetCutInfo () const { return cutinfo; }
+  };
+
+}
+
+#endif
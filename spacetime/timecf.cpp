@@ -9,6 +9,9 @@ namespace ngfem
   ///
   double TimeVariableCoefficientFunction::Evaluate (const BaseMappedIntegrationPoint & mip) const
   {
+    // the time is stored as third coordinate of the reference point, 3D points have no free slot
+    if (mip.GetTransformation().SpaceDim() == 3)
+      throw Exception("ReferenceTimeVariable: time is not available in 3D integration points");
     return mip.IP()(2);
   }
 
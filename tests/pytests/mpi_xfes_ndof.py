@@ -0,0 +1,59 @@
+# run with: mpirun -np 4 python3 -m pytest mpi_xfes_ndof.py
+from ngsolve import *
+from netgen.geom2d import unit_square
+import netgen.meshing
+from xfem import *
+
+def test_mpi_xfes_ndof():
+    comm = mpi_world
+    ngmesh = unit_square.GenerateMesh(maxh=0.1) if comm.rank == 0 else None
+
+    levelsets = [ sqrt((x-0.5)*(x-0.5)+(y-0.5)*(y-0.5)) - 0.3,
+                  sqrt((x-0.4)*(x-0.4)+(y-0.55)*(y-0.55)) - 0.25 ]
+
+    def count_facets(mesh, ba):
+        # a facet at a process interface is counted on the lowest process that has it
+        fes = FacetFESpace(mesh, order=0)
+        pardofs = fes.ParallelDofs()
+        cnt = 0
+        for f in range(mesh.nfacets):
+            if not ba[f]:
+                continue
+            dof = fes.GetDofNrs(NodeId(FACET,f))[0]
+            if all(comm.rank < p for p in pardofs.Dof2Proc(dof)):
+                cnt += 1
+        return cnt
+
+    def ndofs_and_facets(mesh):
+        # the same CutInfo and XFESpace are updated with every level set
+        lsetp1 = GridFunction(H1(mesh,order=1))
+        InterpolateToP1(levelsets[0],lsetp1)
+        ci = CutInfo(mesh, lsetp1)
+        Vh = H1(mesh, order=2)
+        Vhx = XFESpace(Vh, ci)
+        results = []
+        for levelset in levelsets:
+            InterpolateToP1(levelset,lsetp1)
+            ci.Update(lsetp1)
+            Vhx.Update()
+            facets = GetFacetsWithNeighborTypes(mesh, a=ci.GetElementsOfType(IF), b=ci.GetElementsOfType(HASNEG))
+            results.append((Vhx.ndofglobal, count_facets(mesh, facets)))
+        return results
+
+    # reference values on the sequential mesh
+    if comm.rank == 0:
+        results_seq = ndofs_and_facets(Mesh(ngmesh))
+    else:
+        results_seq = [(0,0) for levelset in levelsets]
+
+    if comm.rank == 0:
+        mesh = Mesh(ngmesh.Distribute(comm))
+    else:
+        mesh = Mesh(netgen.meshing.Mesh.Receive(comm))
+
+    results_par = ndofs_and_facets(mesh)
+    for (ndof_seq, nfacets_seq), (ndof_par, nfacets_par) in zip(results_seq, results_par):
+        assert ndof_par == comm.Sum(ndof_seq)
+        # facets between cut elements that are distributed on two processes
+        # have to be found on both of them
+        assert comm.Sum(nfacets_par) == comm.Sum(nfacets_seq)
@@ -89,3 +89,144 @@ def test_intcurved(quad_dominated, order):
     assert sum(eoc_curved[IF][s:])/len(eoc_curved[IF][s:]) > order + 0.75
     assert sum(eoc_curved[NEG][s:])/len(eoc_curved[NEG][s:]) > order + 0.75
     assert sum(eoc_curved[POS][s:])/len(eoc_curved[POS][s:]) > order + 0.75
+
+
+@pytest.mark.parametrize("order", [2,3])
+def test_point_search_statistics(order):
+    mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8, mapping = lambda x,y : (2*x-1,2*y-1))
+    lsetmeshadap = LevelSetMeshAdaptation(mesh, order=order, threshold=0.2, discontinuous_qn=True)
+
+    PointSearchStatistics(reset=True)
+    lsetmeshadap.CalcDeformation(sqrt(x*x+y*y)-0.5)
+    stats = PointSearchStatistics(reset=True)
+
+    assert stats["searches"] > 0
+    assert stats["failures"] == 0
+    assert stats["max_iterations"] < 20
+    assert PointSearchStatistics()["searches"] == 0
+
+
+def test_incremental_deformation():
+    mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8, mapping = lambda x,y : (2*x-1,2*y-1))
+    lsetmeshadap_inc = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2, discontinuous_qn=True)
+    lsetmeshadap_ref = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2, discontinuous_qn=True)
+
+    for shift in [0, 0.05, 0.05, 0.1]:
+        levelset = sqrt((x-shift)*(x-shift)+y*y)-0.5
+        deform_inc = lsetmeshadap_inc.CalcDeformation(levelset, incremental=True)
+        deform_ref = lsetmeshadap_ref.CalcDeformation(levelset)
+        diff = deform_inc.vec.CreateVector()
+        diff.data = deform_inc.vec - deform_ref.vec
+        assert Norm(diff) < 1e-8 * Norm(deform_ref.vec)
+
+
+def test_incremental_deformation_after_restricted_calls():
+    mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8, mapping = lambda x,y : (2*x-1,2*y-1))
+    lsetmeshadap_inc = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2, discontinuous_qn=True)
+    lsetmeshadap_ref = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2, discontinuous_qn=True)
+
+    ba = BitArray(mesh.ne)
+    ba.Clear()
+    for i in range(mesh.ne//2):
+        ba.Set(i)
+
+    # calls restricted by ba or with blending must not be reused by the next incremental call
+    levelset = lambda shift : sqrt((x-shift)*(x-shift)+y*y)-0.5
+    lsetmeshadap_inc.CalcDeformation(levelset(0), incremental=True)
+    for shift, options in [(0.05, { "ba" : ba }), (0.1, { "blending" : "quadratic" })]:
+        lsetmeshadap_inc.CalcDeformation(levelset(shift), **options)
+        deform_inc = lsetmeshadap_inc.CalcDeformation(levelset(shift), incremental=True)
+        deform_ref = lsetmeshadap_ref.CalcDeformation(levelset(shift))
+        diff = deform_inc.vec.CreateVector()
+        diff.data = deform_inc.vec - deform_ref.vec
+        assert Norm(diff) < 1e-8 * Norm(deform_ref.vec)
+
+
+def test_max_distance_cutinfo():
+    mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8, mapping = lambda x,y : (2*x-1,2*y-1))
+    lsetmeshadap = LevelSetMeshAdaptation(mesh, order=2, threshold=0.2, discontinuous_qn=True)
+    levelset = sqrt(x*x+y*y)-0.5
+    lsetmeshadap.CalcDeformation(levelset)
+
+    ci = CutInfo(mesh, lsetmeshadap.lset_p1)
+    dist = lsetmeshadap.CalcMaxDistance(levelset)
+    dist_ci = lsetmeshadap.CalcMaxDistance(levelset, cutinfo=ci)
+    with TaskManager():
+        dist_par = lsetmeshadap.CalcMaxDistance(levelset, cutinfo=ci)
+
+    assert dist > 0
+    assert abs(dist - dist_ci) < 1e-14
+    assert dist_par == dist_ci
+
+    # a deformation that is set on the mesh is ignored and restored afterwards
+    mesh.SetDeformation(lsetmeshadap.deform)
+    lsetsurf = Integrate(levelset_domain={"levelset" : lsetmeshadap.lset_p1, "domain_type" : IF},
+                         cf=CoefficientFunction(1.0), mesh=mesh, order=4)
+    dist_deformed = lsetmeshadap.CalcMaxDistance(levelset, cutinfo=ci)
+    lsetsurf_after = Integrate(levelset_domain={"levelset" : lsetmeshadap.lset_p1, "domain_type" : IF},
+                               cf=CoefficientFunction(1.0), mesh=mesh, order=4)
+    mesh.UnsetDeformation()
+    assert abs(dist_deformed - dist_ci) < 1e-14
+    assert abs(lsetsurf - lsetsurf_after) < 1e-14
+
+
+def test_deformation_error_gf_and_cf_lset():
+    # the point search of CalcDeformationError evaluates the level set with its gradient:
+    # GridFunction level sets through the finite element, general CFs with difference quotients
+    mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8, mapping = lambda x,y : (2*x-1,2*y-1))
+    lsetmeshadap = LevelSetMeshAdaptation(mesh, order=2, threshold=1000, discontinuous_qn=True)
+    deform = lsetmeshadap.CalcDeformation(sqrt(x*x+y*y)-0.5)
+
+    results = []
+    for lset_ho in [lsetmeshadap.lset_ho, 1.0*lsetmeshadap.lset_ho]:
+        stats = StatisticContainer()
+        PointSearchStatistics(reset=True)
+        CalcDeformationError(lset_ho, lsetmeshadap.lset_p1, deform, lsetmeshadap.qn, stats)
+        search = PointSearchStatistics(reset=True)
+        assert search["searches"] > 0
+        assert search["failures"] == 0
+        assert search["max_iterations"] < 10
+        results.append((stats.ErrorL2Norm[-1], stats.ErrorMaxNorm[-1]))
+
+    assert abs(results[0][0] - results[1][0]) < 1e-6
+    assert abs(results[0][1] - results[1][1]) < 1e-6
+
+
+def test_refine_at_levelset_marks():
+    mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8, mapping = lambda x,y : (2*x-1,2*y-1))
+    levelset = sqrt(x*x+y*y)-0.55
+    lset_p1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1(levelset,lset_p1)
+
+    marked = RefineAtLevelSet(gf=lset_p1, mark_only=True)
+    ci = CutInfo(mesh, lset_p1)
+    assert marked.NumSet() > 0
+    for i in range(mesh.ne):
+        assert marked[i] == ci.GetElementsOfType(IF)[i]
+
+    ne_before = mesh.ne
+    marked = RefineAtLevelSet(gf=lset_p1, levels=2, levelset=levelset)
+    assert mesh.ne > ne_before
+    ci = CutInfo(mesh, lset_p1)
+    assert marked.NumSet() == ci.GetElementsOfType(IF).NumSet()
+
+
+def test_interpolate_p1_vertex_values():
+    mesh = MakeStructured2DMesh(quads = False, nx=7, ny=5, mapping = lambda x,y : (2*x-1,2*y-1))
+    lset_p1 = GridFunction(H1(mesh,order=1))
+    lset_ho = GridFunction(H1(mesh,order=3))
+    f = lambda px,py : px*px+0.3*py-0.1
+    lset_ho.Set(x*x+0.3*y-0.1)
+    with TaskManager():
+        InterpolateToP1(x*x+0.3*y-0.1,lset_p1)
+    for v in mesh.vertices:
+        px, py = v.point
+        dof = lset_p1.space.GetDofNrs(v)[0]
+        assert abs(lset_p1.vec[dof] - f(px,py)) < 1e-14
+
+    lset_p1_gf = GridFunction(H1(mesh,order=1))
+    with TaskManager():
+        InterpolateToP1(lset_ho,lset_p1_gf)
+    diff = lset_p1.vec.CreateVector()
+    diff.data = lset_p1.vec - lset_p1_gf.vec
+    assert Norm(diff) < 1e-10
@@ -126,3 +126,51 @@ def test_nxfem(integration_quadtrig_newold,order):
         assert l2error < 0.003
     if (order == 3):
         assert l2error < 0.0004
+
+
+@pytest.mark.parametrize("quad", [False, True])
+def test_xfes_simd_vs_scalar(quad):
+    from ngsolve.meshes import MakeStructured2DMesh
+    mesh = MakeStructured2DMesh(quads=quad,nx=10,ny=10,mapping=lambda x,y: (2*x-1,2*y-1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1((sqrt(x*x+y*y) - 0.5),lsetp1)
+    ci = CutInfo(mesh, lsetp1)
+    ba_if = ci.GetElementsOfType(IF)
+
+    Vh = H1(mesh, order=2)
+    Vhx = XFESpace(Vh, ci)
+    VhG = FESpace([Vh,Vhx])
+    (u,ux),(v,vx) = VhG.TnT()
+
+    form = grad(u)*grad(v) + (1+x*x)*neg(ux)*neg(vx) + (2+y)*pos(ux)*pos(vx) \
+           + neg_grad(ux)*neg_grad(vx) + 3*pos_grad(ux)*pos_grad(vx) + pos(ux)*neg(vx)
+    lform = (1+x)*neg(vx) + y*pos(vx) + CoefficientFunction((x,y))*neg_grad(vx)
+
+    # the same forms with the vectorized and the scalar evaluation
+    mats, vecs, applied = [], [], []
+    gf = GridFunction(VhG)
+    gf.components[0].Set(x*y)
+    gf.components[1].vec[:] = 1
+    for simd in [True, False]:
+        a = BilinearForm(VhG, check_unused=False)
+        a += SymbolicBFI(form, definedonelements=ba_if, simd_evaluate=simd)
+        a.Assemble()
+        f = LinearForm(VhG)
+        f += SymbolicLFI(lform, definedonelements=ba_if, simd_evaluate=simd)
+        f.Assemble()
+        a_nonassembled = BilinearForm(VhG, check_unused=False, nonassemble=True)
+        a_nonassembled += SymbolicBFI(form, definedonelements=ba_if, simd_evaluate=simd)
+        r = gf.vec.CreateVector()
+        a_nonassembled.Apply(gf.vec, r)
+
+        w = gf.vec.CreateVector()
+        w.data = a.mat * gf.vec
+        mats.append(w)
+        vecs.append(f.vec)
+        applied.append(r)
+
+    for vs in [mats, vecs, applied]:
+        diff = vs[0].CreateVector()
+        diff.data = vs[0] - vs[1]
+        assert Norm(vs[1]) > 0
+        assert Norm(diff) < 1e-12 * Norm(vs[1])
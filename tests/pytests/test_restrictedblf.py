@@ -0,0 +1,152 @@
+from ngsolve import *
+from ngsolve.meshes import *
+from xfem import *
+
+def test_restricted_compressed_solve():
+    mesh = MakeStructured2DMesh(quads=False,nx=16,ny=16,mapping=lambda x,y: (2*x-1,2*y-1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1((sqrt(x*x+y*y) - 0.5),lsetp1)
+    ci = CutInfo(mesh, lsetp1)
+    hasneg = ci.GetElementsOfType(HASNEG)
+
+    Vh = H1(mesh, order=2)
+    u,v = Vh.TrialFunction(), Vh.TestFunction()
+
+    a = RestrictedBilinearForm(Vh, element_restriction=hasneg, check_unused=False, reuse_graph=True)
+    a += SymbolicBFI(grad(u)*grad(v)+u*v)
+    a.Assemble()
+    # second assembly re-uses the stored graph table
+    a.Assemble()
+
+    f = LinearForm(Vh)
+    f += SymbolicLFI(levelset_domain = { "levelset" : lsetp1, "domain_type" : NEG}, form = v)
+    f.Assemble()
+
+    active = a.GetActiveDofs(only_free=True)
+    assert active.NumSet() < Vh.ndof
+
+    gfu_full = GridFunction(Vh)
+    gfu_full.vec.data = a.mat.Inverse(active, inverse="sparsecholesky") * f.vec
+
+    cmat, emb = a.CompressedMatrix(active)
+    assert cmat.height == active.NumSet()
+    gfu_comp = GridFunction(Vh)
+    gfu_comp.vec.data = emb * cmat.Inverse(inverse="sparsecholesky") * emb.T * f.vec
+
+    gfu_comp.vec.data -= gfu_full.vec
+    assert Norm(gfu_comp.vec) < 1e-10
+
+
+def test_restricted_compressed_sparsity():
+    mesh = MakeStructured2DMesh(quads=True,nx=12,ny=12,mapping=lambda x,y: (2*x-1,2*y-1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1((sqrt(x*x+y*y) - 0.6),lsetp1)
+    ci = CutInfo(mesh, lsetp1)
+    hasneg = ci.GetElementsOfType(HASNEG)
+
+    Vh = H1(mesh, order=3)
+    u,v = Vh.TrialFunction(), Vh.TestFunction()
+    a = RestrictedBilinearForm(Vh, element_restriction=hasneg, check_unused=False)
+    a += SymbolicBFI(grad(u)*grad(v)+u*v)
+    a.Assemble()
+
+    f = LinearForm(Vh)
+    f += SymbolicLFI(levelset_domain = { "levelset" : lsetp1, "domain_type" : NEG}, form = v)
+    f.Assemble()
+
+    active = a.GetActiveDofs(only_free=True)
+    gfu_full = GridFunction(Vh)
+    gfu_full.vec.data = a.mat.Inverse(active, inverse="sparsecholesky") * f.vec
+    nze_full = a.mat.nze
+
+    # the compressed matrix has (at most) the entries of the active rows and columns
+    cmat, emb = a.CompressedMatrix(active, release_full=True)
+    assert cmat.nze <= nze_full
+    gfu_comp = GridFunction(Vh)
+    gfu_comp.vec.data = emb * cmat.Inverse(inverse="sparsecholesky") * emb.T * f.vec
+    gfu_comp.vec.data -= gfu_full.vec
+    assert Norm(gfu_comp.vec) < 1e-10
+
+    # a new assembly allocates the full matrix again
+    a.Assemble()
+    assert a.mat.nze == nze_full
+
+
+def test_restricted_reuse_graph_changing_domain():
+    mesh = MakeStructured2DMesh(quads=False,nx=12,ny=12,mapping=lambda x,y: (2*x-1,2*y-1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1((sqrt(x*x+y*y) - 0.4),lsetp1)
+    ci = CutInfo(mesh, lsetp1)
+    hasneg = ci.GetElementsOfType(HASNEG)
+
+    Vh = H1(mesh, order=2)
+    u,v = Vh.TrialFunction(), Vh.TestFunction()
+    a = RestrictedBilinearForm(Vh, element_restriction=hasneg, check_unused=False, reuse_graph=True)
+    a += SymbolicBFI(grad(u)*grad(v)+u*v)
+    a.Assemble()
+
+    # the active domain grows, only the rows of the changed elements are recomputed
+    InterpolateToP1((sqrt((x-0.1)*(x-0.1)+y*y) - 0.55),lsetp1)
+    ci.Update(lsetp1)
+    a.Assemble()
+
+    a_ref = RestrictedBilinearForm(Vh, element_restriction=ci.GetElementsOfType(HASNEG), check_unused=False)
+    a_ref += SymbolicBFI(grad(u)*grad(v)+u*v)
+    a_ref.Assemble()
+    assert a.mat.nze == a_ref.mat.nze
+
+    active = a_ref.GetActiveDofs(only_free=True)
+    f = GridFunction(Vh)
+    f.Set(1+x)
+    sol = f.vec.CreateVector()
+    sol_ref = f.vec.CreateVector()
+    sol.data = a.mat.Inverse(active, inverse="sparsecholesky") * f.vec
+    sol_ref.data = a_ref.mat.Inverse(active, inverse="sparsecholesky") * f.vec
+    sol.data -= sol_ref
+    assert Norm(sol) < 1e-10
+
+    # after invalidation the table is built from scratch
+    a.InvalidateGraph()
+    a.Assemble()
+    assert a.mat.nze == a_ref.mat.nze
+
+
+def test_restricted_reuse_graph_xfespace():
+    mesh = MakeStructured2DMesh(quads=False,nx=12,ny=12,mapping=lambda x,y: (2*x-1,2*y-1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1((sqrt(x*x+y*y) - 0.4),lsetp1)
+    ci = CutInfo(mesh, lsetp1)
+    hasneg = ci.GetElementsOfType(HASNEG)
+
+    Vh = H1(mesh, order=1)
+    Vhx = XFESpace(Vh, ci)
+    VhG = FESpace([Vh,Vhx])
+    (u,ux),(v,vx) = VhG.TnT()
+    form = grad(u)*grad(v) + u*v + neg(ux)*neg(vx) + pos(ux)*pos(vx)
+
+    a = RestrictedBilinearForm(VhG, element_restriction=hasneg, check_unused=False, reuse_graph=True)
+    a += SymbolicBFI(form)
+    a.Assemble()
+
+    # the circle is moved by one mesh cell: the xdofs are renumbered, but
+    # their number (and the number of rows) stays the same
+    ndof = VhG.ndof
+    InterpolateToP1((sqrt((x-1/6)*(x-1/6)+y*y) - 0.4),lsetp1)
+    ci.Update(lsetp1)
+    VhG.Update()
+    assert VhG.ndof == ndof
+    a.Assemble()
+
+    a_ref = RestrictedBilinearForm(VhG, element_restriction=ci.GetElementsOfType(HASNEG), check_unused=False)
+    a_ref += SymbolicBFI(form)
+    a_ref.Assemble()
+    assert a.mat.nze == a_ref.mat.nze
+
+    w = a.mat.CreateColVector()
+    w[:] = 1
+    r = a.mat.CreateColVector()
+    r_ref = a.mat.CreateColVector()
+    r.data = a.mat * w
+    r_ref.data = a_ref.mat * w
+    r.data -= r_ref
+    assert Norm(r) < 1e-12 * Norm(r_ref)
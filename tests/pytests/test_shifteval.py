@@ -42,3 +42,30 @@ def test_shifteval():
   print ("L2-error(new):", error_new)
   assert error_old < 1e-3
   assert error_new < 1e-3
+
+
+def test_shifteval_across_elements():
+  # constant deformations: the shifted points leave the element of the integration point
+  mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8)
+  fes = H1(mesh, order=3)
+  gfu = GridFunction(fes)
+  gfu.Set(x*x*y+y)
+  dfm_back = GridFunction(H1(mesh, order=1, dim=2))
+  dfm_back.Set(CoefficientFunction((0.3,-0.1)))
+  dfm_forth = GridFunction(H1(mesh, order=1, dim=2))
+  dfm_forth.Set(CoefficientFunction((0.05,0.05)))
+  cf = shifted_eval(gfu, back = dfm_back, forth = dfm_forth)
+  for px, py in [(0.4,0.2), (0.71,0.33), (0.9,0.85)]:
+    sx, sy = px + 0.05 - 0.3, py + 0.05 + 0.1
+    assert abs(cf(mesh(px,py)) - (sx*sx*sy+sy)) < 1e-8
+
+def test_shifteval_3d():
+  mesh = MakeStructured3DMesh(hexes = False, nx=4, ny=4, nz=4)
+  gfu = GridFunction(H1(mesh, order=2))
+  gfu.Set(x*y+z)
+  dfm_back = GridFunction(H1(mesh, order=1, dim=3))
+  dfm_back.Set(CoefficientFunction((0.3,0.1,-0.2)))
+  cf = shifted_eval(gfu, back = dfm_back)
+  for px, py, pz in [(0.5,0.2,0.3), (0.8,0.6,0.1)]:
+    sx, sy, sz = px - 0.3, py - 0.1, pz + 0.2
+    assert abs(cf(mesh(px,py,pz)) - (sx*sy+sz)) < 1e-8
@@ -64,3 +64,245 @@ def test_spacetime_integrateX_via_straight_cutted_quad2Dplus1D(domain, quad_domi
     error = abs(integral - referencevals[domain])
     
     assert error < 5e-15
+
+
+@pytest.mark.parametrize("quad_dominated", [True, False])
+@pytest.mark.parametrize("domain", [NEG, POS, IF])
+@pytest.mark.parametrize("time_order", [3, 4])
+def test_spacetime_integrateX_high_order_time(domain, quad_dominated, time_order):
+    mesh = MakeStructured2DMesh(quads = quad_dominated, nx=1, ny=1)    
+
+    levelset = lambda t : 1 - 2*x - 2*t
+    referencevals = { POS : 1./8, NEG : 1 - 1/8, IF : 1.0/2 }
+
+    h1fes = H1(mesh,order=1)
+    lset_approx_h1 = GridFunction(h1fes)
+    tfe = ScalarTimeFE(time_order) 
+    fes= SpaceTimeFESpace(h1fes,tfe)
+    lset_approx = GridFunction(fes)
+
+    # nodal interpolation in time, roots are found with the Bernstein root isolation
+    for i,ti in enumerate(fes.TimeFE_nodes()):
+        InterpolateToP1(levelset(ti),lset_approx_h1)
+        lset_approx.vec[i*h1fes.ndof:(i+1)*h1fes.ndof].data = lset_approx_h1.vec
+
+    f = CoefficientFunction(1)
+    
+    integral = Integrate(levelset_domain = { "levelset" : lset_approx, "domain_type" : domain},
+                         cf=f, mesh=mesh, order = 0, time_order=0)
+    print("Integral: ", integral)
+    error = abs(integral - referencevals[domain])
+    
+    assert error < 1e-12
+
+
+@pytest.mark.parametrize("quad_dominated", [True, False])
+@pytest.mark.parametrize("domain", [NEG, POS, IF])
+@pytest.mark.parametrize("skip_first_node", [False, True])
+def test_spacetime_integrateX_nonlinear_in_time(domain, quad_dominated, skip_first_node):
+    mesh = MakeStructured2DMesh(quads = quad_dominated, nx=1, ny=1)
+
+    # cubic in time, the vertex at x=0 changes its sign at t=1/2
+    h = lambda t : 3*t**2 - 2*t**3
+    # with skip_first_node the level set has to vanish at t=0
+    levelset = lambda t : (t if skip_first_node else 1) * (1 - 2*x - 2*h(t))
+    referencevals = { POS : 5./32, NEG : 27./32, IF : 1.0/2 }
+
+    h1fes = H1(mesh,order=1)
+    lset_approx_h1 = GridFunction(h1fes)
+    fes= SpaceTimeFESpace(h1fes,ScalarTimeFE(4, skip_first_node=skip_first_node))
+    lset_approx = GridFunction(fes)
+
+    i = 0
+    for k,tk in enumerate(fes.TimeFE_nodes()):
+        if fes.IsTimeNodeActive(k):
+            InterpolateToP1(levelset(tk),lset_approx_h1)
+            lset_approx.vec[i*h1fes.ndof:(i+1)*h1fes.ndof].data = lset_approx_h1.vec
+            i += 1
+
+    integral = Integrate(levelset_domain = { "levelset" : lset_approx, "domain_type" : domain},
+                         cf=CoefficientFunction(1), mesh=mesh, order = 0, time_order=3)
+    print("Integral: ", integral)
+    error = abs(integral - referencevals[domain])
+
+    assert error < 1e-12
+
+
+@pytest.mark.parametrize("quad_dominated", [True, False])
+@pytest.mark.parametrize("domain", [NEG, POS, IF])
+@pytest.mark.parametrize("time_order", [1, 2])
+def test_spacetime_integrateX_time_invariant(domain, quad_dominated, time_order):
+    mesh = MakeStructured2DMesh(quads = quad_dominated, nx=1, ny=1)
+
+    # level set does not depend on time: tensor product of spatial cut rule and time rule
+    levelset = 1 - 2*x
+    referencevals = { POS : 1./6, NEG : 1./6, IF : 1./3 }
+
+    h1fes = H1(mesh,order=1)
+    lset_approx_h1 = GridFunction(h1fes)
+    fes= SpaceTimeFESpace(h1fes,ScalarTimeFE(time_order))
+    lset_approx = GridFunction(fes)
+
+    InterpolateToP1(levelset,lset_approx_h1)
+    for i in range(time_order+1):
+        lset_approx.vec[i*h1fes.ndof:(i+1)*h1fes.ndof].data = lset_approx_h1.vec
+
+    integral = Integrate(levelset_domain = { "levelset" : lset_approx, "domain_type" : domain},
+                         cf=tref*tref, mesh=mesh, order = 0, time_order=2)
+    print("Integral: ", integral)
+    error = abs(integral - referencevals[domain])
+
+    assert error < 1e-12
+
+
+def test_spacetime_restrict_batched():
+    mesh = MakeStructured2DMesh(quads = False, nx=4, ny=4)
+
+    h1fes = H1(mesh,order=1)
+    tfe = ScalarTimeFE(2)
+    fes = SpaceTimeFESpace(h1fes,tfe)
+    gf = GridFunction(fes)
+
+    told = Parameter(0)
+    f = lambda t : x + t*t
+    SpaceTimeInterpolateToP1(f(told),told,0.0,1.0,gf)
+
+    times = [0.1, 0.5, 0.75, 1.0]
+    gfs_batched = CreateTimeRestrictedGF(gf,times)
+    gfs_single = [CreateTimeRestrictedGF(gf,t) for t in times]
+    for t, gfb, gfs in zip(times, gfs_batched, gfs_single):
+        assert Norm(gfb.vec - gfs.vec) < 1e-14
+        error = sqrt(Integrate((gfb - f(t))**2, mesh))
+        assert error < 1e-12
+
+    # restriction overwrites (and does not accumulate) old values
+    RestrictGFInTime(spacetime_gf=gf, reference_times=times, space_gfs=gfs_batched)
+    for t, gfb in zip(times, gfs_batched):
+        error = sqrt(Integrate((gfb - f(t))**2, mesh))
+        assert error < 1e-12
+
+
+@pytest.mark.parametrize("time_order", [1, 2])
+def test_spacetime_interpolate_reference_time(time_order):
+    mesh = MakeStructured2DMesh(quads = False, nx=4, ny=4)
+
+    h1fes = H1(mesh,order=1)
+    fes = SpaceTimeFESpace(h1fes,ScalarTimeFE(time_order))
+    gf_param = GridFunction(fes)
+    gf_reftime = GridFunction(fes)
+
+    told = Parameter(0.2)
+    delta_t = Parameter(0.5)
+    t = told + delta_t * ReferenceTimeVariable()
+    f = x - y + t*t
+
+    # time via the parameter (set and reset for every time node)
+    SpaceTimeInterpolateToP1(f,told,0.2,0.5,gf_param)
+    assert told.Get() == 0.2
+    # time via the reference time of the nodes (no global state changed)
+    SpaceTimeInterpolateToP1(f,None,spacetime_gf=gf_reftime)
+
+    assert Norm(gf_param.vec - gf_reftime.vec) < 1e-14
+
+
+@pytest.mark.parametrize("skeleton", [True, False])
+@pytest.mark.parametrize("time_weight", ["one", "tref"])
+def test_spacetime_ghostpenalty_tensor_structure(skeleton, time_weight):
+    mesh = MakeStructured2DMesh(quads = False, nx=3, ny=3)
+
+    h1fes = H1(mesh,order=1,dgjumps=True)
+    fes = SpaceTimeFESpace(h1fes,ScalarTimeFE(1),flags = {"dgjumps": True})
+    ns = h1fes.ndof
+
+    # mass matrices of the linear nodal time basis with weights 1 and t
+    tmass = { "one"  : [[1/3, 1/6], [1/6, 1/3]],
+              "tref" : [[1/12, 1/12], [1/12, 1/4]] }[time_weight]
+    coef = { "one" : CoefficientFunction(1), "tref" : tref }[time_weight]
+
+    u,v = fes.TnT()
+    a_st = BilinearForm(fes,check_unused=False)
+    a_st += SymbolicFacetPatchBFI(form = coef*(u-u.Other())*(v-v.Other()) + coef*InnerProduct(grad(u)-grad(u.Other()),grad(v)),
+                                  skeleton=skeleton, time_order=2)
+    a_st.Assemble()
+
+    us,vs = h1fes.TnT()
+    a_s = BilinearForm(h1fes,check_unused=False)
+    a_s += SymbolicFacetPatchBFI(form = (us-us.Other())*(vs-vs.Other()) + InnerProduct(grad(us)-grad(us.Other()),grad(vs)),
+                                 skeleton=skeleton)
+    a_s.Assemble()
+
+    # a_st = tmass (x) a_s for time-independent integrands
+    x_st = a_st.mat.CreateColVector()
+    y_st = a_st.mat.CreateColVector()
+    x_s = a_s.mat.CreateColVector()
+    y_s = a_s.mat.CreateColVector()
+    for i in range(len(x_st)):
+        x_st[i] = (i*7) % 11 - 5
+    y_st.data = a_st.mat * x_st
+
+    for a in range(2):
+        ref = a_s.mat.CreateColVector()
+        ref[:] = 0
+        for b in range(2):
+            x_s.data = x_st[b*ns:(b+1)*ns]
+            y_s.data = a_s.mat * x_s
+            ref.data += tmass[a][b] * y_s
+        ref.data -= y_st[a*ns:(a+1)*ns]
+        assert Norm(ref) < 1e-10 * max(1, Norm(y_st))
+
+
+@pytest.mark.parametrize("time_order", [3, 4, 5])
+def test_spacetime_high_order_time_nodal_basis(time_order):
+    mesh = MakeStructured2DMesh(quads = False, nx=2, ny=2)
+
+    h1fes = H1(mesh,order=1)
+    fes = SpaceTimeFESpace(h1fes,ScalarTimeFE(time_order))
+    gf = GridFunction(fes)
+
+    # polynomials of degree time_order in time are represented exactly
+    told = Parameter(0)
+    f = lambda t : x + (1-t)**time_order + 0.5*t
+    SpaceTimeInterpolateToP1(f(told),told,0.0,1.0,gf)
+
+    times = [0.05, 0.3, 0.5, 0.9]
+    for t, gft in zip(times, CreateTimeRestrictedGF(gf,times)):
+        error = sqrt(Integrate((gft - f(t))**2, mesh))
+        assert error < 1e-12
+
+    # time derivative of the nodal basis
+    lset = GridFunction(SpaceTimeFESpace(h1fes,ScalarTimeFE(1)))
+    lset.vec[:] = -1
+    error = sqrt(Integrate(levelset_domain = { "levelset" : lset, "domain_type" : NEG},
+                           cf = (dt(gf) + time_order*(1-tref)**(time_order-1) - 0.5)**2,
+                           mesh=mesh, order=2, time_order=2*time_order))
+    assert error < 1e-10
+
+
+def test_spacetime_3d_fixed_time():
+    mesh = MakeStructured3DMesh(hexes = False, nx=2, ny=2, nz=2)
+
+    fes = SpaceTimeFESpace(H1(mesh,order=1),ScalarTimeFE(1))
+    gf = GridFunction(fes)
+    told = Parameter(0)
+    SpaceTimeInterpolateToP1((x+y+z)*told,told,0.0,1.0,gf)
+
+    # evaluation at a fixed time (scalar and SIMD paths)
+    assert abs(Integrate(fix_t(gf,1), mesh) - 1.5) < 1e-12
+    assert abs(Integrate(fix_t(gf,0), mesh)) < 1e-12
+    fes.SetTime(1)
+    assert abs(Integrate(gf, mesh) - 1.5) < 1e-12
+    fes.SetOverrideTime(False)
+
+    # assembly of a mass matrix at the end of the time slab
+    u,v = fes.TnT()
+    a = BilinearForm(fes)
+    a += fix_t(u,1)*fix_t(v,1)*dx
+    a.Assemble()
+    w = gf.vec.CreateVector()
+    w.data = a.mat * gf.vec
+    assert abs(InnerProduct(w, gf.vec) - 2.5) < 1e-12
+
+    # no space-time cut rules on 3D meshes (no time coordinate in the point)
+    with pytest.raises(Exception):
+        Integrate(levelset_domain = { "levelset" : gf, "domain_type" : NEG},
+                  cf = 1, mesh = mesh, order = 1, time_order = 1)
@@ -277,3 +277,61 @@ def test_new_integrateX_via_orth_cutted_quad3D(order, domain, quad_dominated, di
     error = abs(integral - referencevals[domain])
     
     assert error < 5e-15*(order+1)*(order+1)
+
+
+@pytest.mark.parametrize("quad_dominated", [False, True])
+@pytest.mark.parametrize("lsetorder", [2,3])
+@pytest.mark.parametrize("domain", [NEG, POS, IF])
+
+def test_highorder_lset_circle(quad_dominated, lsetorder, domain):
+    # the circle is exactly represented by the P2/P3 level set, no mesh deformation needed
+    r=0.6
+    mesh = MakeStructured2DMesh(quads = quad_dominated, nx=8, ny=8)
+    referencevals = { POS : 1-pi*r*r/4, NEG : pi*r*r/4, IF : r*pi/2}
+
+    lset_ho = GridFunction(H1(mesh,order=lsetorder))
+    lset_ho.Set(x*x+y*y-r*r)
+
+    integral = Integrate(levelset_domain = { "levelset" : lset_ho, "domain_type" : domain, "highorder_lset" : True},
+                         cf=CoefficientFunction(1), mesh=mesh, order = 8)
+    error = abs(integral - referencevals[domain])
+    print("Error: ", error)
+    assert error < 1e-8
+
+
+@pytest.mark.parametrize("quad_dominated", [False, True])
+@pytest.mark.parametrize("domain", [NEG, IF])
+
+def test_highorder_lset_sphere(quad_dominated, domain):
+    r=0.6
+    mesh = MakeStructured3DMesh(hexes = quad_dominated, nx=4, ny=4, nz=4)
+    referencevals = { NEG : pi*r**3/6, IF : pi*r*r/2}
+
+    lset_ho = GridFunction(H1(mesh,order=2))
+    lset_ho.Set(x*x+y*y+z*z-r*r)
+
+    integral = Integrate(levelset_domain = { "levelset" : lset_ho, "domain_type" : domain, "highorder_lset" : True},
+                         cf=CoefficientFunction(1), mesh=mesh, order = 6)
+    error = abs(integral - referencevals[domain])
+    print("Error: ", error)
+    assert error < 1e-6
+
+
+@pytest.mark.parametrize("domain", [NEG, POS, IF])
+
+def test_highorder_lset_default_vertex_values(domain):
+    # without highorder_lset only the vertex values of a higher order level set are used
+    r=0.6
+    mesh = MakeStructured2DMesh(quads = False, nx=8, ny=8)
+
+    lset_ho = GridFunction(H1(mesh,order=2))
+    lset_ho.Set(x*x+y*y-r*r)
+    lset_p1 = GridFunction(H1(mesh,order=1))
+    lset_p1.Set(x*x+y*y-r*r)
+
+    integral_ho = Integrate(levelset_domain = { "levelset" : lset_ho, "domain_type" : domain},
+                            cf=CoefficientFunction(1), mesh=mesh, order = 2)
+    integral_p1 = Integrate(levelset_domain = { "levelset" : lset_p1, "domain_type" : domain},
+                            cf=CoefficientFunction(1), mesh=mesh, order = 2)
+    print("Difference: ", abs(integral_ho - integral_p1))
+    assert abs(integral_ho - integral_p1) < 1e-12
@@ -19,3 +19,36 @@ def test_xfes_ndof_3D():
     Vhx = XFESpace(Vh, lsetp1)
     assert Vh.ndof == 125
     assert Vhx.ndof == 35
+
+def test_xfes_numpy_views():
+    import numpy as np
+    mesh = MakeStructured2DMesh(quads=False,nx=4,ny=4,mapping=lambda x,y: (2*x-1,2*y-1))
+    lsetp1 = GridFunction(H1(mesh,order=1))
+    InterpolateToP1((sqrt(x*x+y*y) - 1.0/3.0),lsetp1)
+    ci = CutInfo(mesh, lsetp1)
+    Vh = H1(mesh, order=1)
+    Vhx = XFESpace(Vh, ci)
+
+    ratios = ci.GetCutRatiosNumPy(VOL)
+    assert np.allclose(ratios, np.array(ci.GetCutRatios(VOL)))
+
+    ba = ci.GetElementsOfType(IF)
+    bits = np.unpackbits(ci.GetElementsOfTypeNumPy(IF), count=mesh.ne, bitorder='little')
+    assert all(bool(bits[i]) == ba[i] for i in range(mesh.ne))
+
+    doms = Vhx.GetDomainOfDofsNumPy()
+    xdof2base = Vhx.BaseDofOfXDofNumPy()
+    base2xdof = Vhx.XDofOfBaseDofNumPy()
+    assert len(doms) == Vhx.ndof
+    for i in range(Vhx.ndof):
+        assert doms[i] == int(Vhx.GetDomainOfDof(i))
+        assert xdof2base[i] == Vhx.BaseDofOfXDof(i)
+        assert base2xdof[xdof2base[i]] == i
+
+    # the arrays are copies and stay valid after an Update of the space
+    doms_before = np.array(doms)
+    InterpolateToP1((sqrt(x*x+y*y) - 0.6),lsetp1)
+    ci.Update(lsetp1)
+    Vhx.Update()
+    assert np.array_equal(doms, doms_before)
+    assert len(Vhx.GetDomainOfDofsNumPy()) == Vhx.ndof
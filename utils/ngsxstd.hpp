@@ -77,3 +77,13 @@ INLINE DOMAIN_TYPE INVERT( DOMAIN_TYPE dt)
 
 
 void IterateRange (int ne, LocalHeap & clh, const function<void(int,LocalHeap&)> & func);
+
+/// interface of FESpaces whose dof numbering depends on the cut and can
+/// change in an Update without a change of ndof: the stamp changes whenever
+/// the dof numbering may have changed
+class CutDependentDofNumbering
+{
+public:
+  virtual ~CutDependentDofNumbering () { ; }
+  virtual size_t GetDofNumberingStamp () const = 0;
+};
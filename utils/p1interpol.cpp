@@ -5,6 +5,7 @@
 /*********************************************************************/
 
 #include "p1interpol.hpp"
+#include "ngsxstd.hpp"
 
 namespace ngcomp
 {
@@ -22,6 +23,69 @@ namespace ngcomp
     : ma(a_gf_p1->GetMeshAccess()), coef(nullptr), gf(a_gf), gf_p1(a_gf_p1)
   {; }
 
+  void EvaluateAtVertices (shared_ptr<MeshAccess> ma, shared_ptr<CoefficientFunction> coef,
+                           FlatArray<double> ref_times, SliceMatrix<> vals, LocalHeap & clh)
+  {
+    static Timer time_fct ("EvaluateAtVertices");
+    RegionTimer reg (time_fct);
+
+    if (coef->Dimension() != 1)
+      throw Exception ("EvaluateAtVertices: only scalar coefficient functions");
+    if (ref_times.Size() > 0 && ma->GetDimension() != 2)
+      throw Exception ("EvaluateAtVertices: reference times only on 2D meshes");
+
+    const int nv = ma->GetNV();
+    const int ne = ma->GetNE();
+    const int nt = max(int(ref_times.Size()), 1);
+
+    Array<int> owner(nv);
+    ParallelForRange (Range(nv), [&](IntRange r)
+    {
+      Array<int> elnums;
+      for (int vnr : r)
+      {
+        ma->GetVertexElements (vnr, elnums);
+        owner[vnr] = elnums.Size() > 0 ? elnums[0] : -1;
+        for (int elnr : elnums)
+          owner[vnr] = min(owner[vnr], elnr);
+      }
+    });
+
+    IterateRange
+      (ne, clh, [&] (int elnr, LocalHeap & lh)
+    {
+      ElementId ei(VOL,elnr);
+      Ngs_Element ngel = ma->GetElement(ei);
+      auto verts = ngel.Vertices();
+
+      ArrayMem<int,8> owned;
+      for (int loc = 0; loc < verts.Size(); loc++)
+        if (owner[verts[loc]] == elnr)
+          owned.Append(loc);
+      if (owned.Size() == 0)
+        return;
+
+      const POINT3D * refverts = ElementTopology::GetVertices(ngel.GetType());
+      IntegrationRule ir(nt*owned.Size(), lh);
+      for (int k = 0; k < nt; k++)
+        for (int j = 0; j < owned.Size(); j++)
+        {
+          const int loc = owned[j];
+          ir[k*owned.Size()+j] = IntegrationPoint(refverts[loc][0], refverts[loc][1],
+                                                  ref_times.Size() > 0 ? ref_times[k] : refverts[loc][2], 0.0);
+        }
+
+      auto & eltrans = ma->GetTrafo (ei, lh);
+      auto & mir = eltrans(ir, lh);
+      FlatMatrix<> cfvals(ir.Size(), 1, lh);
+      coef->Evaluate(mir, cfvals);
+
+      for (int k = 0; k < nt; k++)
+        for (int j = 0; j < owned.Size(); j++)
+          vals(k,verts[owned[j]]) = cfvals(k*owned.Size()+j,0);
+    });
+  }
+
   void InterpolateP1::Do(LocalHeap & lh, double eps_perturbation)
   {
     static Timer time_fct ("LsetCurv::InterpolateP1::Do");
@@ -30,63 +94,43 @@ namespace ngcomp
     int nv=ma->GetNV();
     gf_p1->GetVector() = 0.0;
 
-    for (int vnr = 0; vnr < nv; ++vnr)
+    Vector<> vertex_vals(nv);
+    vertex_vals = 0.0;
+    if (coef)
     {
-      HeapReset hr(lh);
-
-      double val_lset;
-      if (coef)
+      if (ma->GetDimension() != 2 && ma->GetDimension() != 3)
+        throw Exception ("D==0,D==1 not yet implemnted");
+      EvaluateAtVertices(ma, coef, FlatArray<double>(0,(double*)nullptr),
+                         SliceMatrix<>(1, nv, nv, &vertex_vals(0)), lh);
+    }
+    else
+    {
+      ParallelForRange (Range(nv), [&](IntRange r)
       {
-        Array<int> elnums;
-        ma -> GetVertexElements (vnr, elnums);
-        Ngs_Element ngel = ma -> GetElement (ElementId(VOL,elnums[0]));
-        auto & eltrans = ma -> GetTrafo (ngel, lh);
-
-        if( ma -> GetDimension() == 2)
-        {
-          Vec<2> point;
-          ma->GetPoint<2>(vnr,point);
-          IntegrationPoint ip(0,0,0,0);
-          MappedIntegrationPoint<2,2> mip(ip,eltrans);
-          Vec<2> refpoint = mip.GetJacobianInverse() * (point - mip.GetPoint());
-          IntegrationPoint ip_f(refpoint[0],refpoint[1],0.0,0.0);
-          MappedIntegrationPoint<2,2> mip_f(ip_f,eltrans);
-          val_lset = coef->Evaluate(mip_f);
-        }
-        else if ( ma -> GetDimension() == 3)
+        Array<int> dof;
+        for (int vnr : r)
         {
-          Vec<3> point;
-          ma->GetPoint<3>(vnr,point);
-          IntegrationPoint ip(0,0,0,0);
-          MappedIntegrationPoint<3,3> mip(ip,eltrans);
-          Vec<3> refpoint = mip.GetJacobianInverse() * (point - mip.GetPoint());
-          IntegrationPoint ip_f(refpoint,0.0);
-          MappedIntegrationPoint<3,3> mip_f(ip_f,eltrans);
-          val_lset = coef->Evaluate(mip_f);
+          gf->GetFESpace()->GetDofNrs(NodeId(NT_VERTEX,vnr), dof);
+          gf->GetVector().GetIndirect(dof,vertex_vals.Range(vnr,vnr+1));
         }
-        else
-          throw Exception ("D==0,D==1 not yet implemnted");
-      }
-      else
-      {
-        Array<int> dof;
-        // gf->GetFESpace()->GetVertexDofNrs(vnr, dof);
-        gf->GetFESpace()->GetDofNrs(NodeId(NT_VERTEX,vnr), dof); //vnr, dof);
-        FlatVector<> fval(1,&val_lset);
-        gf->GetVector().GetIndirect(dof,fval);
-      }
-
-      Array<int> dof;
-      gf_p1->GetFESpace()->GetVertexDofNrs(vnr,dof);
-      FlatVector<> val(1,&val_lset);
-      // avoid vertex cuts by introducing a small perturbation:
-      if (abs(val(0)) < eps_perturbation)
-        val(0) = eps_perturbation;
-      if (dof[0] != -1)
-        gf_p1->GetVector().SetIndirect(dof,val);
+      });
     }
 
-
+    FlatVector<> vec_p1 = gf_p1->GetVector().FVDouble();
+    ParallelForRange (Range(nv), [&](IntRange r)
+    {
+      Array<int> dof;
+      for (int vnr : r)
+      {
+        gf_p1->GetFESpace()->GetVertexDofNrs(vnr,dof);
+        double val = vertex_vals(vnr);
+        // avoid vertex cuts by introducing a small perturbation:
+        if (abs(val) < eps_perturbation)
+          val = eps_perturbation;
+        if (dof[0] != -1)
+          vec_p1(dof[0]) = val;
+      }
+    });
   }
 
 }
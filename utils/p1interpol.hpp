@@ -22,6 +22,16 @@ namespace ngcomp
    or an h1ho function into the space of
    piecewise linears
    ---------------------------------------- */
+
+  /// Evaluates the scalar coef in all vertices of the mesh. The loop runs element-wise in
+  /// parallel, every vertex is evaluated by its owner only (the element with the smallest number
+  /// among the elements of the vertex). All owned vertices of an element are mapped with one
+  /// integration rule. vals(k,vnr) is the value in vertex vnr for the reference time ref_times[k]
+  /// (passed as third coordinate of the integration point, only for D=2). Without ref_times,
+  /// vals has one row. Vertices without elements are left untouched.
+  void EvaluateAtVertices (shared_ptr<MeshAccess> ma, shared_ptr<CoefficientFunction> coef,
+                           FlatArray<double> ref_times, SliceMatrix<> vals, LocalHeap & clh);
+
   class InterpolateP1
   {
   protected:
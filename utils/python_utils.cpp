@@ -20,7 +20,7 @@ void ExportNgsx_utils(py::module &m)
   m.def("InterpolateToP1",  [] (PyGF gf_ho, PyGF gf_p1, double eps_perturbation, int heapsize)
         {
           InterpolateP1 interpol(gf_ho, gf_p1);
-          LocalHeap lh (heapsize, "InterpolateP1-Heap");
+          LocalHeap lh (heapsize, "InterpolateP1-Heap", true);
           interpol.Do(lh,eps_perturbation);
         } ,
         py::arg("gf_ho")=NULL,py::arg("gf_p1")=NULL,
@@ -51,7 +51,7 @@ heapsize : int
   m.def("InterpolateToP1",  [] (PyCF coef, PyGF gf_p1, double eps_perturbation, int heapsize)
         {
           InterpolateP1 interpol(coef, gf_p1);
-          LocalHeap lh (heapsize, "InterpolateP1-Heap");
+          LocalHeap lh (heapsize, "InterpolateP1-Heap", true);
           interpol.Do(lh,eps_perturbation);
         } ,
         py::arg("coef"),py::arg("gf"),
@@ -88,9 +88,12 @@ heapsize : int
            py::object ael_restriction,
            py::object afac_restriction,
            bool check_unused,
+           bool reuse_graph,
            py::dict bpflags)
         {
           Flags flags = py::extract<Flags> (bpflags)();
+          if (reuse_graph)
+            flags.SetFlag("reuse_graph");
 
           shared_ptr<BitArray> el_restriction = nullptr;
           shared_ptr<BitArray> fac_restriction = nullptr;
@@ -112,6 +115,7 @@ heapsize : int
         py::arg("element_restriction") = DummyArgument(),
         py::arg("facet_restriction") = DummyArgument(),
         py::arg("check_unused") = true,
+        py::arg("reuse_graph") = false,
         py::arg("flags") = py::dict(),
         docu_string(R"raw_string(
 A restricted bilinear form is a (so far real-valued) bilinear form with a reduced MatrixGraph
@@ -147,10 +151,79 @@ facet_restriction : ngsolve.BitArray
 check_unused : boolean
   Check if some degrees of freedoms are not considered during assembly
 
+reuse_graph : boolean
+  Keep the element/facet-to-dof table of the last matrix graph. When the matrix is re-created
+  (e.g. in every time step of a moving domain problem) only the rows of elements/facets whose
+  restriction changed are recomputed. Only use this if the dof numbering of the space does not
+  change between two calls (this is not the case for an XFESpace).
+
 flags : ngsolve.Flags
   additional bilinear form flags
 )raw_string"));
 
+  typedef shared_ptr<RestrictedBilinearForm> PyRBLF;
+  py::class_<RestrictedBilinearForm, PyRBLF, BilinearForm>
+    (m, "CRestrictedBilinearForm",docu_string(R"raw_string(
+RestrictedBilinearForm-class [For documentation of the RestrictedBilinearForm-constructor see
+help(RestrictedBilinearForm)]:
+
+Real-valued bilinear form with a MatrixGraph that is reduced to the active elements/facets.
+)raw_string"))
+    .def("GetActiveDofs", [](PyRBLF self, bool only_free)
+         {
+           return self->GetActiveDofs(only_free);
+         },
+         py::arg("only_free") = true,
+         docu_string(R"raw_string(
+BitArray of all degrees of freedom of the active elements.
+
+Parameters
+
+only_free : boolean
+  only mark degrees of freedom that are also free dofs of the FESpace.
+)raw_string"))
+    .def("InvalidateGraph", [](PyRBLF self)
+         {
+           self->InvalidateGraph();
+         },
+         docu_string(R"raw_string(
+Forget the stored element/facet-to-dof table (see reuse_graph). Call this if the dof numbering
+of the space changed, e.g. after an Update() of an XFESpace.
+)raw_string"))
+    .def("CompressedMatrix", [](PyRBLF self, py::object aactive_dofs, bool release_full)
+         {
+           shared_ptr<BitArray> active_dofs = nullptr;
+           if (py::extract<PyBA> (aactive_dofs).check())
+             active_dofs = py::extract<PyBA>(aactive_dofs)();
+           else
+             active_dofs = self->GetActiveDofs(true);
+           shared_ptr<BaseMatrix> cmat = self->CreateCompressedMatrix(active_dofs);
+           shared_ptr<BaseMatrix> embedding = make_shared<ActiveDofEmbedding>(active_dofs);
+           if (release_full)
+             self->ReleaseMatrix();
+           return py::make_tuple(cmat, embedding);
+         },
+         py::arg("active_dofs") = DummyArgument(),
+         py::arg("release_full") = true,
+         docu_string(R"raw_string(
+Copies the assembled matrix into a sparse matrix that is indexed by the active degrees of freedom
+only. Returns a tuple (A_c, E) of the compressed matrix and the embedding operator E. E maps a
+compressed vector to a full-size vector (E * x_c) and E.T restricts a full-size vector to the
+active dofs (E.T * x). A full solution can be obtained as
+
+  x.data = E * A_c.Inverse() * E.T * f
+
+Parameters
+
+active_dofs : ngsolve.BitArray / None
+  degrees of freedom to keep. If not provided, GetActiveDofs(only_free=True) is used.
+
+release_full : boolean
+  free the full-size matrix after the copy, so that only the compressed matrix is kept in
+  memory. The next Assemble() allocates a new full-size matrix.
+)raw_string"))
+    ;
+
   m.def("CompoundBitArray",
         [] (py::list balist)
         {
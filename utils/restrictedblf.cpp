@@ -1,9 +1,25 @@
 #include "restrictedblf.hpp"
 #include <comp.hpp>
+#include "ngsxstd.hpp"
 
 namespace ngcomp
 {
 
+  // the dof numbering of spaces that depend on the cut (also as components
+  // of compound spaces) can change in an Update without a change of ndof.
+  // The update counters of all of them are summed up, the sum changes if
+  // any of them is updated.
+  static size_t DofNumberingStamp (const FESpace & fes)
+  {
+    if (auto cutfes = dynamic_cast<const CutDependentDofNumbering*>(&fes))
+      return cutfes->GetDofNumberingStamp();
+    size_t stamp = 0;
+    if (auto compfes = dynamic_cast<const CompoundFESpace*>(&fes))
+      for (int i = 0; i < compfes->GetNSpaces(); i++)
+        stamp += DofNumberingStamp(*(*compfes)[i]);
+    return stamp;
+  }
+
   RestrictedBilinearForm :: 
   RestrictedBilinearForm (shared_ptr<FESpace> afespace,
                           const string & aname,
@@ -14,14 +30,24 @@ namespace ngcomp
       el_restriction(ael_restriction),
       fac_restriction(afac_restriction)
   {
-    ;
+    reuse_graph = flags.GetDefineFlag("reuse_graph");
+  }
+
+  void RestrictedBilinearForm :: InvalidateGraph ()
+  {
+    graph_table = nullptr;
+    graph_el_restriction = nullptr;
+    graph_fac_restriction = nullptr;
+    graph_ndof = 0;
+    graph_dof_stamp = 0;
   }
-  
   
   
   MatrixGraph * RestrictedBilinearForm :: GetGraph (int level, bool symmetric)
   {
-    static Timer timer ("BilinearForm::GetGraph");
+    static Timer timer ("RestrictedBilinearForm::GetGraph");
+    static Timer timer_table ("RestrictedBilinearForm::GetGraph - table");
+    static Timer timer_graph ("RestrictedBilinearForm::GetGraph - matrixgraph");
     RegionTimer reg (timer);
 
     int ndof = fespace->GetNDof();
@@ -32,108 +58,351 @@ namespace ngcomp
     const Array<SpecialElement*> & specialelements = fespace->GetSpecialElements();
     int nspe = specialelements.Size();
 
-    Array<DofId> dnums;
-    Array<int> fnums; //facets of one element
-    Array<int> elnums; //elements neighbouring one facet
-    Array<int> nbelems; //neighbour elements
-
-
     int maxind = neV + neB + neBB + specialelements.Size();
     if (fespace->UsesDGCoupling()) maxind += nf;
 
-    TableCreator<int> creator(maxind);
-    for ( ; !creator.Done(); creator++)
+    // rows of the previous table can be taken over if the dof numbering
+    // (checked via ndof, the number of rows and the update counters of cut
+    // dependent spaces) is the same and the element/facet has not been
+    // (de)activated in between
+    const size_t dof_stamp = DofNumberingStamp(*fespace);
+    bool patch = reuse_graph && graph_table && graph_table->Size() == size_t(maxind) && graph_ndof == size_t(ndof)
+      && graph_dof_stamp == dof_stamp
+      && (bool(el_restriction) == bool(graph_el_restriction))
+      && (bool(fac_restriction) == bool(graph_fac_restriction))
+      && (!el_restriction || el_restriction->Size() == graph_el_restriction->Size())
+      && (!fac_restriction || fac_restriction->Size() == graph_fac_restriction->Size());
+
+    auto el_changed = [&] (int i)
       {
-	for(VorB vb : {VOL, BND, BBND})
-	  {
-	    int nre = ma->GetNE(vb);
-	    ParallelForRange (Range(nre), [&](IntRange r)
-			      {
-				Array<DofId> dnums;
-				for (auto i : r)
-				  {
-                                    // if (vb == VOL)
-                                    //   if (el_restriction && (! el_restriction->Test(i)))
-                                    //     continue;
-                                    if (vb == VOL)
-                                      if (el_restriction && (! el_restriction->Test(i)))
-                                        continue;
-				    auto eid = ElementId(vb,i);
-				    if (!fespace->DefinedOn (vb,ma->GetElIndex(eid)))
-                                      continue;
-				    
-				    if (vb == VOL && eliminate_internal)
-				      fespace->GetDofNrs (eid, dnums, EXTERNAL_DOF);
-				    else
-				      fespace->GetDofNrs (eid, dnums);
-				    int shift = (vb==VOL) ? 0 : ((vb==BND) ? neV : neV+neB);
-				    for (int d : dnums)
-				      if (d != -1) creator.Add (shift+i, d);
-                              }
-			      });
-	  }
-
-        
-        for (int i = 0; i < specialelements.Size(); i++)
-          {
-            specialelements[i]->GetDofNrs (dnums);
-            for (int d : dnums)
-              if (d != -1) creator.Add (neV+neB+neBB+i, d);
-          }
+        return el_restriction && (el_restriction->Test(i) != graph_el_restriction->Test(i));
+      };
+    auto fac_changed = [&] (int i)
+      {
+        return fac_restriction && (fac_restriction->Test(i) != graph_fac_restriction->Test(i));
+      };
 
-        if (fespace->UsesDGCoupling())
-        {
-          //add dofs of neighbour elements as well
-          Array<DofId> dnums_dg;
-          Array<int> elnums_per;
+    bool nothing_changed = patch;
+    if (patch && el_restriction)
+      for (int i = 0; i < neV && nothing_changed; i++)
+        if (el_changed(i)) nothing_changed = false;
+    if (patch && fac_restriction && fespace->UsesDGCoupling())
+      for (int i = 0; i < nf && nothing_changed; i++)
+        if (fac_changed(i)) nothing_changed = false;
 
-          for (int i = 0; i < nf; i++)
+    if (!nothing_changed)
+    {
+      RegionTimer regt (timer_table);
+      TableCreator<int> creator(maxind);
+      for ( ; !creator.Done(); creator++)
+        {
+          for(VorB vb : {VOL, BND, BBND})
             {
-              if (fac_restriction && (! fac_restriction->Test(i)))
-                continue;
-              nbelems.SetSize(0);
-              ma->GetFacetElements(i,elnums);
-              for (int k=0; k<elnums.Size(); k++)
-                nbelems.Append(elnums[k]);
-
-              if(nbelems.Size() < 2)
-              {
-                int facet2 = ma->GetPeriodicFacet(i);
-                if(facet2 != i)
-                {
-                  ma->GetFacetElements (facet2, elnums_per);
-                  nbelems.Append(elnums_per[0]);
-                }
-              }
-              dnums_dg.SetSize(0);
-              for (int k=0;k<nbelems.Size();k++){
-                int elnr=nbelems[k];
-                if (!fespace->DefinedOn (VOL,ma->GetElIndex(ElementId(VOL,elnr)))) continue;
-                fespace->GetDofNrs (ElementId(VOL,elnr), dnums);
-                dnums_dg.Append(dnums);
-              }
-              QuickSort (dnums_dg);
-              for (int j = 0; j < dnums_dg.Size(); j++)
-                if (dnums_dg[j] != -1 && (j==0 || (dnums_dg[j] != dnums_dg[j-1]) ))
-                  creator.Add (neV+neB+neBB+nspe+i, dnums_dg[j]);
+              int nre = ma->GetNE(vb);
+              int shift = (vb==VOL) ? 0 : ((vb==BND) ? neV : neV+neB);
+              ParallelForRange (Range(nre), [&](IntRange r)
+                                {
+                                  Array<DofId> dnums;
+                                  for (auto i : r)
+                                    {
+                                      if (patch && (vb != VOL || !el_changed(i)))
+                                      {
+                                        for (int d : (*graph_table)[shift+i])
+                                          creator.Add (shift+i, d);
+                                        continue;
+                                      }
+                                      if (vb == VOL)
+                                        if (el_restriction && (! el_restriction->Test(i)))
+                                          continue;
+                                      auto eid = ElementId(vb,i);
+                                      if (!fespace->DefinedOn (vb,ma->GetElIndex(eid)))
+                                        continue;
+
+                                      if (vb == VOL && eliminate_internal)
+                                        fespace->GetDofNrs (eid, dnums, EXTERNAL_DOF);
+                                      else
+                                        fespace->GetDofNrs (eid, dnums);
+                                      for (int d : dnums)
+                                        if (d != -1) creator.Add (shift+i, d);
+                                    }
+                                });
             }
+
+          ParallelForRange (Range(nspe), [&](IntRange r)
+                            {
+                              Array<DofId> dnums;
+                              for (auto i : r)
+                                {
+                                  specialelements[i]->GetDofNrs (dnums);
+                                  for (int d : dnums)
+                                    if (d != -1) creator.Add (neV+neB+neBB+i, d);
+                                }
+                            });
+
+          if (fespace->UsesDGCoupling())
+          {
+            //add dofs of neighbour elements as well
+            int shift = neV+neB+neBB+nspe;
+            ParallelForRange (Range(nf), [&](IntRange r)
+                              {
+                                Array<DofId> dnums;
+                                Array<DofId> dnums_dg;
+                                Array<int> elnums; //elements neighbouring one facet
+                                Array<int> elnums_per;
+                                Array<int> nbelems; //neighbour elements
+                                for (auto i : r)
+                                  {
+                                    if (patch && !fac_changed(i))
+                                    {
+                                      for (int d : (*graph_table)[shift+i])
+                                        creator.Add (shift+i, d);
+                                      continue;
+                                    }
+                                    if (fac_restriction && (! fac_restriction->Test(i)))
+                                      continue;
+                                    nbelems.SetSize(0);
+                                    ma->GetFacetElements(i,elnums);
+                                    for (int k=0; k<elnums.Size(); k++)
+                                      nbelems.Append(elnums[k]);
+
+                                    if(nbelems.Size() < 2)
+                                    {
+                                      int facet2 = ma->GetPeriodicFacet(i);
+                                      if(facet2 != i)
+                                      {
+                                        ma->GetFacetElements (facet2, elnums_per);
+                                        nbelems.Append(elnums_per[0]);
+                                      }
+                                    }
+                                    dnums_dg.SetSize(0);
+                                    for (int k=0;k<nbelems.Size();k++){
+                                      int elnr=nbelems[k];
+                                      if (!fespace->DefinedOn (VOL,ma->GetElIndex(ElementId(VOL,elnr)))) continue;
+                                      fespace->GetDofNrs (ElementId(VOL,elnr), dnums);
+                                      dnums_dg.Append(dnums);
+                                    }
+                                    QuickSort (dnums_dg);
+                                    for (int j = 0; j < dnums_dg.Size(); j++)
+                                      if (dnums_dg[j] != -1 && (j==0 || (dnums_dg[j] != dnums_dg[j-1]) ))
+                                        creator.Add (shift+i, dnums_dg[j]);
+                                  }
+                              });
+          }
         }
+      graph_table = make_shared<Table<int>>(creator.MoveTable());
+    }
+
+    if (reuse_graph)
+    {
+      graph_ndof = ndof;
+      graph_dof_stamp = dof_stamp;
+      graph_el_restriction = el_restriction ? make_shared<BitArray>(*el_restriction) : nullptr;
+      graph_fac_restriction = fac_restriction ? make_shared<BitArray>(*fac_restriction) : nullptr;
+    }
 
-      }
-    
     MatrixGraph * graph;
 
     if (!fespace2)
       {
-        auto table = creator.MoveTable();
-        graph = new MatrixGraph (ndof, ndof, table, table, symmetric);
+        RegionTimer regg (timer_graph);
+        graph = new MatrixGraph (ndof, ndof, *graph_table, *graph_table, symmetric);
       }
     else
       {
         throw Exception("not yet implemented");
       }
 
+    if (!reuse_graph)
+      graph_table = nullptr;
+
     graph -> FindSameNZE();
     return graph;
   }
+
+
+  shared_ptr<BitArray> RestrictedBilinearForm :: GetActiveDofs (bool only_free) const
+  {
+    static Timer timer ("RestrictedBilinearForm::GetActiveDofs");
+    RegionTimer reg (timer);
+
+    size_t ndof = fespace->GetNDof();
+    auto active = make_shared<BitArray>(ndof);
+    active->Clear();
+
+    // only bits are set, a race between two threads setting the same
+    // bit leads to the same result
+    for (VorB vb : {VOL, BND})
+      ParallelForRange (Range(ma->GetNE(vb)), [&](IntRange r)
+                        {
+                          Array<DofId> dnums;
+                          for (auto i : r)
+                          {
+                            if (vb == VOL && el_restriction && (! el_restriction->Test(i)))
+                              continue;
+                            ElementId eid(vb,i);
+                            if (!fespace->DefinedOn (vb,ma->GetElIndex(eid)))
+                              continue;
+                            fespace->GetDofNrs (eid, dnums);
+                            for (int d : dnums)
+                              if (d != -1) active->SetBitAtomic(d);
+                          }
+                        });
+
+#ifdef PARALLEL
+    // dofs at process interfaces are active if they are active on any process
+    if (fespace->GetParallelDofs())
+    {
+      Array<int> active_flag(ndof);
+      for (size_t i = 0; i < ndof; i++)
+        active_flag[i] = active->Test(i) ? 1 : 0;
+      fespace->GetParallelDofs()->AllReduceDofData (active_flag, MPI_MAX);
+      for (size_t i = 0; i < ndof; i++)
+        if (active_flag[i])
+          active->Set(i);
+    }
+#endif
+
+    if (only_free && fespace->GetFreeDofs())
+      active->And(*fespace->GetFreeDofs());
+    return active;
+  }
+
+  shared_ptr<BaseSparseMatrix> RestrictedBilinearForm :: CreateCompressedMatrix (shared_ptr<BitArray> active_dofs) const
+  {
+    static Timer timer ("RestrictedBilinearForm::CreateCompressedMatrix");
+    RegionTimer reg (timer);
+
+#ifdef PARALLEL
+    if (dynamic_pointer_cast<ParallelMatrix>(GetMatrixPtr()))
+      throw Exception("RestrictedBilinearForm::CreateCompressedMatrix: not available for distributed matrices");
+#endif
+    auto mat = dynamic_pointer_cast<SparseMatrix<double>>(GetMatrixPtr());
+    if (!mat)
+      throw Exception("RestrictedBilinearForm::CreateCompressedMatrix: no assembled (real) sparse matrix");
+    bool symmetric = dynamic_pointer_cast<SparseMatrixSymmetric<double>>(mat) != nullptr;
+
+    size_t ndof = mat->Height();
+    if (active_dofs->Size() != ndof)
+      throw Exception("RestrictedBilinearForm::CreateCompressedMatrix: active dofs do not match matrix size");
+
+    Array<int> full2active(ndof);
+    int nactive = 0;
+    for (size_t i = 0; i < ndof; i++)
+      full2active[i] = active_dofs->Test(i) ? nactive++ : -1;
+
+    // CSR graph with the active columns of each active row. The renumbering
+    // is monotone, so the (lower triangular) structure of a symmetric matrix
+    // is preserved.
+    Array<int> elsperrow(nactive);
+    ParallelForRange (Range(ndof), [&](IntRange r)
+                      {
+                        for (auto i : r)
+                        {
+                          if (full2active[i] == -1) continue;
+                          int cnt = 0;
+                          for (int j : mat->GetRowIndices(i))
+                            if (full2active[j] != -1)
+                              cnt++;
+                          elsperrow[full2active[i]] = cnt;
+                        }
+                      });
+    MatrixGraph graph(elsperrow, nactive);
+    // rows are independent, every thread only fills its own rows
+    ParallelForRange (Range(ndof), [&](IntRange r)
+                      {
+                        for (auto i : r)
+                        {
+                          if (full2active[i] == -1) continue;
+                          for (int j : mat->GetRowIndices(i))
+                            if (full2active[j] != -1)
+                              graph.CreatePosition(full2active[i], full2active[j]);
+                        }
+                      });
+
+    shared_ptr<SparseMatrix<double>> cmat;
+    if (symmetric)
+      cmat = make_shared<SparseMatrixSymmetric<double>>(graph, false);
+    else
+      cmat = make_shared<SparseMatrix<double>>(graph, false);
+    cmat->SetZero();
+
+    ParallelForRange (Range(ndof), [&](IntRange r)
+                      {
+                        for (auto i : r)
+                        {
+                          int ci = full2active[i];
+                          if (ci == -1) continue;
+                          auto cols = mat->GetRowIndices(i);
+                          auto vals = mat->GetRowValues(i);
+                          for (int k = 0; k < cols.Size(); k++)
+                          {
+                            int cj = full2active[cols[k]];
+                            if (cj != -1)
+                              (*cmat)(ci,cj) = vals[k];
+                          }
+                        }
+                      });
+    return cmat;
+  }
+
+
+  void RestrictedBilinearForm :: ReleaseMatrix ()
+  {
+    mats.SetSize(0);
+  }
+
+
+  ActiveDofEmbedding :: ActiveDofEmbedding (shared_ptr<BitArray> active_dofs)
+    : ndof_full(active_dofs->Size())
+  {
+    active2full.SetSize(active_dofs->NumSet());
+    int cnt = 0;
+    for (size_t i = 0; i < ndof_full; i++)
+      if (active_dofs->Test(i))
+        active2full[cnt++] = i;
+  }
+
+  AutoVector ActiveDofEmbedding :: CreateRowVector () const
+  {
+    return make_shared<VVector<double>>(active2full.Size());
+  }
+
+  AutoVector ActiveDofEmbedding :: CreateColVector () const
+  {
+    return make_shared<VVector<double>>(ndof_full);
+  }
+
+  void ActiveDofEmbedding :: Mult (const BaseVector & x, BaseVector & y) const
+  {
+    y = 0.0;
+    MultAdd (1.0, x, y);
+  }
+
+  void ActiveDofEmbedding :: MultAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    auto fx = x.FVDouble();
+    auto fy = y.FVDouble();
+    ParallelForRange (Range(active2full), [&](IntRange r)
+                      {
+                        for (auto i : r)
+                          fy(active2full[i]) += s * fx(i);
+                      });
+  }
+
+  void ActiveDofEmbedding :: MultTrans (const BaseVector & x, BaseVector & y) const
+  {
+    y = 0.0;
+    MultTransAdd (1.0, x, y);
+  }
+
+  void ActiveDofEmbedding :: MultTransAdd (double s, const BaseVector & x, BaseVector & y) const
+  {
+    auto fx = x.FVDouble();
+    auto fy = y.FVDouble();
+    ParallelForRange (Range(active2full), [&](IntRange r)
+                      {
+                        for (auto i : r)
+                          fy(i) += s * fx(active2full[i]);
+                      });
+  }
 }
@@ -8,6 +8,15 @@ namespace ngcomp
   {
     shared_ptr<BitArray> el_restriction = nullptr;
     shared_ptr<BitArray> fac_restriction = nullptr;
+
+    /// keep the element/facet-to-dof table of the last graph and only
+    /// recompute the rows of elements/facets whose restriction changed
+    bool reuse_graph = false;
+    shared_ptr<Table<int>> graph_table = nullptr;
+    shared_ptr<BitArray> graph_el_restriction = nullptr;
+    shared_ptr<BitArray> graph_fac_restriction = nullptr;
+    size_t graph_ndof = 0;
+    size_t graph_dof_stamp = 0;
   public:
     /// generate a bilinear-form
     // RestrictedBilinearForm () ;
@@ -27,6 +36,43 @@ namespace ngcomp
     //     	  const Flags & flags);
 
     virtual MatrixGraph * GetGraph (int level, bool symmetric);
+
+    /// forget the stored graph table (e.g. after the dof numbering changed)
+    void InvalidateGraph ();
+
+    /// dofs of the active elements (optionally intersected with the free dofs)
+    shared_ptr<BitArray> GetActiveDofs (bool only_free = true) const;
+
+    /// copy of the assembled matrix indexed by the active dofs only
+    shared_ptr<BaseSparseMatrix> CreateCompressedMatrix (shared_ptr<BitArray> active_dofs) const;
+
+    /// free the assembled full-size matrix (e.g. once a compressed copy exists),
+    /// the next Assemble allocates a new one
+    void ReleaseMatrix ();
+  };
+
+  /// Embedding of a vector of active dofs into a full-size vector (Mult)
+  /// and restriction of a full-size vector to the active dofs (MultTrans)
+  class ActiveDofEmbedding : public BaseMatrix
+  {
+    size_t ndof_full;
+    Array<int> active2full;
+  public:
+    ActiveDofEmbedding (shared_ptr<BitArray> active_dofs);
+
+    const Array<int> & ActiveDofs () const { return active2full; }
+
+    virtual bool IsComplex () const { return false; }
+    virtual int VHeight () const { return ndof_full; }
+    virtual int VWidth () const { return active2full.Size(); }
+
+    virtual AutoVector CreateRowVector () const;
+    virtual AutoVector CreateColVector () const;
+
+    virtual void Mult (const BaseVector & x, BaseVector & y) const;
+    virtual void MultAdd (double s, const BaseVector & x, BaseVector & y) const;
+    virtual void MultTrans (const BaseVector & x, BaseVector & y) const;
+    virtual void MultTransAdd (double s, const BaseVector & x, BaseVector & y) const;
   };
 
 }
@@ -117,6 +117,10 @@ namespace ngcomp
       *selems_of_domain_type[CDOM_HASPOS] = *selems_of_domain_type[CDOM_POS] | *selems_of_domain_type[CDOM_IF];
     }
 
+    // markings of a previous level set are removed, the loop below only sets bits
+    for (NODE_TYPE nt : {NT_VERTEX,NT_EDGE,NT_FACE,NT_CELL})
+      cut_neighboring_node[nt]->Clear();
+
     int ne = ma -> GetNE();
     IterateRange
       (ne, lh,
@@ -130,19 +134,19 @@ namespace ngcomp
 
         nodenums = ma->GetElVertices(elid);
         for (int node : nodenums)
-          cut_neighboring_node[NT_VERTEX]->Set(node);
+          cut_neighboring_node[NT_VERTEX]->SetBitAtomic(node);
 
         nodenums = ma->GetElEdges(elid);
         for (int node : nodenums)
-          cut_neighboring_node[NT_EDGE]->Set(node);
+          cut_neighboring_node[NT_EDGE]->SetBitAtomic(node);
 
         if (ma->GetDimension() == 3)
         {
           nodenums = ma->GetElFaces(elid.Nr());
           for (int node : nodenums)
-            cut_neighboring_node[NT_FACE]->Set(node);
+            cut_neighboring_node[NT_FACE]->SetBitAtomic(node);
         }
-        cut_neighboring_node[NT_ELEMENT]->Set(elnr);
+        cut_neighboring_node[NT_ELEMENT]->SetBitAtomic(elnr);
       }
     });
 
@@ -183,7 +187,45 @@ namespace ngcomp
 
     });
 
+#ifdef PARALLEL
+    if (MyMPI_GetNTasks() > 1)
+      ExchangeNodeMarkings();
+#endif
+  }
+
+#ifdef PARALLEL
+  void CutInformation::ExchangeNodeMarkings()
+  {
+    static Timer timer ("CutInformation::ExchangeNodeMarkings");
+    RegionTimer reg (timer);
+
+    // cells (and faces in 2D) are not shared between processes
+    Array<NODE_TYPE> shared_nts { NT_VERTEX, NT_EDGE };
+    if (ma->GetDimension() == 3)
+      shared_nts.Append(NT_FACE);
+
+    for (NODE_TYPE nt : shared_nts)
+    {
+      int nn = ma->GetNNodes(nt);
+      // node is cut-neighboring if it is so on any process
+      Array<int> cut_neighboring(nn);
+      for (int i = 0; i < nn; i++)
+        cut_neighboring[i] = cut_neighboring_node[nt]->Test(i) ? 1 : 0;
+      ma->AllReduceNodalData (nt, cut_neighboring, MPI_MAX);
+      for (int i = 0; i < nn; i++)
+        if (cut_neighboring[i])
+          cut_neighboring_node[nt]->Set(i);
+
+      // a node is IF if it is IF on every process (NEG < POS < IF)
+      Array<int> dom(nn);
+      for (int i = 0; i < nn; i++)
+        dom[i] = (*dom_of_node[nt])[i];
+      ma->AllReduceNodalData (nt, dom, MPI_MIN);
+      for (int i = 0; i < nn; i++)
+        (*dom_of_node[nt])[i] = DOMAIN_TYPE(dom[i]);
+    }
   }
+#endif
 
 
   shared_ptr<BitArray> GetFacetsWithNeighborTypes(shared_ptr<MeshAccess> ma,
@@ -200,6 +242,18 @@ namespace ngcomp
 
     BitArray fine_facet(nf);
     fine_facet.Clear();
+
+#ifdef PARALLEL
+    // per (local) boundary facet: number of neighbor elements, number of
+    // neighbors with a, with b and with a and b, accumulated over all
+    // processes (2 bits each)
+    Array<int> parallel_counts(0);
+    if (MyMPI_GetNTasks() > 1)
+    {
+      parallel_counts.SetSize(nf);
+      parallel_counts = 0;
+    }
+#endif
     IterateRange
       (ma->GetNE(VOL), lh,
       [&] (int elnr, LocalHeap & lh)
@@ -219,6 +273,18 @@ namespace ngcomp
         Array<int> elnums(0,lh);
         ma->GetFacetElements (facnr, elnums);
 
+#ifdef PARALLEL
+        // the neighbor on the other side can be on another process, decide
+        // after the information of both sides has been exchanged
+        if (parallel_counts.Size() && elnums.Size() < 2 && ma->GetPeriodicFacet(facnr) == facnr)
+        {
+          bool a_el = a->Test(elnums[0]);
+          bool b_el = b->Test(elnums[0]);
+          parallel_counts[facnr] = 1 + (a_el ? 4 : 0) + (b_el ? 16 : 0) + (a_el && b_el ? 64 : 0);
+          return;
+        }
+#endif
+
         if(elnums.Size() < 2)
         {
           int facet2 = ma->GetPeriodicFacet(facnr);
@@ -249,6 +315,25 @@ namespace ngcomp
         }
       }
     });
+
+#ifdef PARALLEL
+    if (parallel_counts.Size())
+    {
+      ma->AllReduceNodalData (ma->GetDimension() == 3 ? NT_FACE : NT_EDGE, parallel_counts, MPI_SUM);
+      for (int facnr = 0; facnr < nf; facnr++)
+      {
+        int cnt = parallel_counts[facnr];
+        if (cnt == 0) continue;
+        int n_el = cnt & 3, n_a = (cnt >> 2) & 3, n_b = (cnt >> 4) & 3, n_ab = (cnt >> 6) & 3;
+        // facets at the physical boundary are not marked (as in the sequential case)
+        if (n_el < 2) continue;
+        // (a_l && b_r) || (a_r && b_l) only fails if a and b are only set on the same side
+        bool and_result = n_a > 0 && n_b > 0 && !(n_a == 1 && n_b == 1 && n_ab == 1);
+        if (ask_and ? and_result : (n_a > 0 || n_b > 0))
+          ret->Set(facnr);
+      }
+    }
+#endif
     return ret;
   }
 
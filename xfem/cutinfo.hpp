@@ -32,6 +32,10 @@ namespace ngcomp
     shared_ptr<Array<DOMAIN_TYPE>> dom_of_node [6] = {nullptr, nullptr, nullptr,
                                                       nullptr, nullptr, nullptr};
     double subdivlvl = 0;
+#ifdef PARALLEL
+    /// make marking of nodes at process interfaces consistent
+    void ExchangeNodeMarkings();
+#endif
   public:
     CutInformation (shared_ptr<MeshAccess> ama);
     void Update(shared_ptr<CoefficientFunction> lset, int time_order, LocalHeap & lh);
@@ -1,4 +1,5 @@
 #include <python_ngstd.hpp>
+#include <pybind11/numpy.h>
 #include "../xfem/sFESpace.hpp"
 #include "../xfem/cutinfo.hpp"
 #include "../xfem/xFESpace.hpp"
@@ -8,6 +9,34 @@
 
 using namespace ngcomp;
 
+/// numpy array on the memory of data without copying, the
+/// owner is kept alive as long as the numpy array exists
+template <typename T, typename TOWNER>
+py::array_t<T> MakeNumPyView (T * data, size_t n, shared_ptr<TOWNER> owner)
+{
+  auto keep_alive = new shared_ptr<TOWNER>(owner);
+  py::capsule base(keep_alive, [](void * p) { delete reinterpret_cast<shared_ptr<TOWNER>*>(p); });
+  return py::array_t<T>( { n }, { sizeof(T) }, data, base);
+}
+
+/// numpy array with a copy of data, for arrays that are reallocated
+/// by their owner (e.g. in an Update of an XFESpace)
+template <typename T>
+py::array_t<T> MakeNumPyCopy (const T * data, size_t n)
+{
+  py::array_t<T> arr(n);
+  std::copy(data, data+n, arr.mutable_data());
+  return arr;
+}
+
+/// packed (8 bits per byte, little bit order) numpy view on a BitArray
+py::array_t<unsigned char> MakePackedBitArrayView (shared_ptr<BitArray> ba)
+{
+  return MakeNumPyView(ba->Data(), (ba->Size()+CHAR_BIT-1)/CHAR_BIT, ba);
+}
+
+static_assert(sizeof(DOMAIN_TYPE) == sizeof(int), "DOMAIN_TYPE arrays are exported as int arrays");
+
 void ExportNgsx_xfem(py::module &m)
 {
 
@@ -161,6 +190,54 @@ corresponding combined domain type
          py::arg("VOL_or_BND") = VOL,docu_string(R"raw_string(
 Returns Vector of the ratios between the measure of the NEG domain on a (boundary) element and the
 full (boundary) element
+)raw_string"))
+
+    .def("GetCutRatiosNumPy", [](CutInformation & self,
+                                 VorB vb)
+         {
+           auto vec = self.GetCutRatios(vb);
+           return MakeNumPyView(static_cast<double*>(vec->Memory()), vec->Size(), vec);
+         },
+         py::arg("VOL_or_BND") = VOL,docu_string(R"raw_string(
+Returns a numpy array (without copy) of the ratios between the measure of the NEG domain on a
+(boundary) element and the full (boundary) element. The array shares the memory with the CutInfo,
+i.e. it is up to date after every call of Update.
+)raw_string"))
+    .def("GetElementsOfTypeNumPy", [](CutInformation & self,
+                                      py::object dt,
+                                      VorB vb)
+         {
+           COMBINED_DOMAIN_TYPE cdt = CDOM_NO;
+           if (py::extract<COMBINED_DOMAIN_TYPE> (dt).check())
+             cdt = py::extract<COMBINED_DOMAIN_TYPE>(dt)();
+           else if (py::extract<DOMAIN_TYPE> (dt).check())
+             cdt = TO_CDT(py::extract<DOMAIN_TYPE>(dt)());
+           else
+             throw Exception(" unknown type for dt ");
+           return MakePackedBitArrayView(self.GetElementsOfDomainType(cdt,vb));
+         },
+         py::arg("domain_type") = IF,
+         py::arg("VOL_or_BND") = VOL,docu_string(R"raw_string(
+Returns the BitArray of GetElementsOfType as a packed numpy array of type uint8 (without copy, 8
+elements per entry, bit order 'little'). Use numpy.unpackbits(..., count=mesh.ne, bitorder='little')
+to obtain one entry per element. The array shares the memory with the CutInfo, i.e. it is up to
+date after every call of Update.
+)raw_string"))
+    .def("GetFacetsOfTypeNumPy", [](CutInformation & self,
+                                    py::object dt)
+         {
+           COMBINED_DOMAIN_TYPE cdt = CDOM_NO;
+           if (py::extract<COMBINED_DOMAIN_TYPE> (dt).check())
+             cdt = py::extract<COMBINED_DOMAIN_TYPE>(dt)();
+           else if (py::extract<DOMAIN_TYPE> (dt).check())
+             cdt = TO_CDT(py::extract<DOMAIN_TYPE>(dt)());
+           else
+             throw Exception(" unknown type for dt ");
+           return MakePackedBitArrayView(self.GetFacetsOfDomainType(cdt));
+         },
+         py::arg("domain_type") = IF,docu_string(R"raw_string(
+Returns the BitArray of GetFacetsOfType as a packed numpy array of type uint8 (without copy, 8
+facets per entry, bit order 'little'), see also GetElementsOfTypeNumPy.
 )raw_string"))
     ;
 
@@ -429,6 +506,30 @@ Parameters
 
 i : int
   degree of freedom 
+)raw_string"))
+    .def("GetDomainOfDofsNumPy", [](PyXFES self)
+         {
+           FlatArray<DOMAIN_TYPE> doms = self->GetDomainOfDofs();
+           return MakeNumPyCopy(reinterpret_cast<int*>(doms.Addr(0)), doms.Size());
+         },docu_string(R"raw_string(
+Returns the domains (as integers, see DOMAIN_TYPE) of all degrees of freedom of the extended
+FESpace as numpy array (copy, an Update of the space does not change it).
+)raw_string"))
+    .def("BaseDofOfXDofNumPy", [](PyXFES self)
+         {
+           FlatArray<int> dofs = self->GetBaseDofsOfXDofs();
+           return MakeNumPyCopy(dofs.Addr(0), dofs.Size());
+         },docu_string(R"raw_string(
+Returns the unknowns of the base FESpace corresponding to all unknowns of the extended space as numpy
+array (copy, an Update of the space does not change it).
+)raw_string"))
+    .def("XDofOfBaseDofNumPy", [](PyXFES self)
+         {
+           FlatArray<int> dofs = self->GetXDofsOfBaseDofs();
+           return MakeNumPyCopy(dofs.Addr(0), dofs.Size());
+         },docu_string(R"raw_string(
+Returns the unknowns of the extended space corresponding to all unknowns of the base FESpace (-1 if
+there is none) as numpy array (copy, an Update of the space does not change it).
 )raw_string"))
     .def("GetDomainNrs",   [] (PyXFES self, int elnr) {
         Array<DOMAIN_TYPE> domnums;
@@ -453,6 +554,7 @@ elnr : int
                              int time_order,
                              int subdivlvl,
                              SWAP_DIMENSIONS_POLICY quad_dir_pol,
+                             bool highorder_lset,
                              PyCF cf,
                              VorB vb,
                              bool element_boundary,
@@ -482,7 +584,7 @@ elnr : int
           shared_ptr<BilinearFormIntegrator> bfi;
           if (!has_other && !skeleton)
           {
-            auto bfime = make_shared<SymbolicCutBilinearFormIntegrator> (lset, cf, dt, order, subdivlvl,quad_dir_pol,vb);
+            auto bfime = make_shared<SymbolicCutBilinearFormIntegrator> (lset, cf, dt, order, subdivlvl,quad_dir_pol,vb,highorder_lset);
             bfime->SetTimeIntegrationOrder(time_order);
             bfi = bfime;
           }
@@ -514,6 +616,7 @@ elnr : int
         py::arg("time_order")=-1,
         py::arg("subdivlvl")=0,
         py::arg("quad_dir_policy")=FIND_OPTIMAL,
+        py::arg("highorder_lset")=false,
         py::arg("form"),
         py::arg("VOL_or_BND")=VOL,
         py::arg("element_boundary")=false,
@@ -599,6 +702,7 @@ time_order : int
                              int time_order,
                              int subdivlvl,
                              SWAP_DIMENSIONS_POLICY quad_dir_pol,
+                             bool highorder_lset,
                              PyCF cf,
                              VorB vb,
                              bool element_boundary,
@@ -618,7 +722,7 @@ time_order : int
           if (element_boundary || skeleton)
             throw Exception("No Facet LFI with Symbolic cuts..");
 
-          auto lfime  = make_shared<SymbolicCutLinearFormIntegrator> (lset, cf, dt, order, subdivlvl, quad_dir_pol,vb);
+          auto lfime  = make_shared<SymbolicCutLinearFormIntegrator> (lset, cf, dt, order, subdivlvl, quad_dir_pol,vb,highorder_lset);
           lfime->SetTimeIntegrationOrder(time_order);
           shared_ptr<LinearFormIntegrator> lfi = lfime;
 
@@ -642,6 +746,7 @@ time_order : int
         py::arg("time_order")=-1,
         py::arg("subdivlvl")=0,
         py::arg("quad_dir_policy")=FIND_OPTIMAL,
+        py::arg("highorder_lset")=false,
         py::arg("form"),
         py::arg("VOL_or_BND")=VOL,
         py::arg("element_boundary")=py::bool_(false),
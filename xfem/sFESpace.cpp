@@ -67,6 +67,7 @@ namespace ngcomp
     // throw Exception ("nothing done yet...");
 
     FESpace::Update(lh);
+    dof_numbering_stamp++;
     int ne=ma->GetNE();
     activeelem.SetSize(ne);
 
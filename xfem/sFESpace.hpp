@@ -9,7 +9,7 @@ using namespace ngsolve;
 namespace ngcomp
 {
 
-  class SFESpace : public FESpace
+  class SFESpace : public FESpace, public CutDependentDofNumbering
   {
   protected:
     int ndof=0;
@@ -18,6 +18,7 @@ namespace ngcomp
     shared_ptr<CoefficientFunction> coef_lset = NULL;
     Array<int> firstdof_of_el;
     Array<Mat<2>> cuts_on_el;
+    size_t dof_numbering_stamp = 0;  // increased with every Update
   public:
     SFESpace (shared_ptr<MeshAccess> ama,
               shared_ptr<CoefficientFunction> a_coef_lset,
@@ -26,6 +27,8 @@ namespace ngcomp
 
     virtual ~SFESpace(){};
 
+    virtual size_t GetDofNumberingStamp () const { return dof_numbering_stamp; }
+
     // a name for our new fe-space
     virtual string GetClassName () const
     {
@@ -11,6 +11,8 @@
 #include <fem.hpp>
 #include "../xfem/symboliccutbfi.hpp"
 #include "../cutint/xintegration.hpp"
+#include "../spacetime/SpaceTimeFE.hpp"
+#include <diffop_impl.hpp>
 namespace ngfem
 {
 
@@ -21,7 +23,8 @@ namespace ngfem
                                      int aforce_intorder,
                                      int asubdivlvl,
                                      SWAP_DIMENSIONS_POLICY apol,
-                                     VorB vb)
+                                     VorB vb,
+                                     bool highorder_lset)
     : SymbolicBilinearFormIntegrator(acf,vb,VOL),
     cf_lset(acf_lset),
     dt(adt),
@@ -29,7 +32,7 @@ namespace ngfem
     subdivlvl(asubdivlvl),
     pol(apol)
   {
-    tie(cf_lset,gf_lset) = CF2GFForStraightCutRule(cf_lset,subdivlvl);
+    tie(cf_lset,gf_lset) = CF2GFForStraightCutRule(cf_lset,subdivlvl,highorder_lset);
   }
 
 
@@ -616,6 +619,130 @@ namespace ngfem
             }
         }
   }
+  // Space-time facet and patch integrals with tensor-product structure:
+  // For scalar space-time elements with value or spatial gradient proxies
+  // the shape functions are (time shape) x (space shape) and the geometry
+  // does not depend on time. Hence, the spatial points are mapped and the
+  // spatial shapes are evaluated only once, for every time point only the
+  // integrand is evaluated and the spatial matrix S(t) = B_test^T D(t) B_trial
+  // is added as tau_test(t) tau_trial(t)^T (x) S(t) to the element matrix.
+  static bool IsSpaceTimeSeparable (const ProxyFunction & proxy)
+  {
+    auto diffop = proxy.Evaluator();
+    return dynamic_pointer_cast<T_DifferentialOperator<DiffOpId<2>>> (diffop)
+      || dynamic_pointer_cast<T_DifferentialOperator<DiffOpGradient<2>>> (diffop);
+  }
+
+  static bool SpaceTimeSumFactorizationApplies (const FiniteElement & fel1, const FiniteElement & fel2,
+                                                FlatArray<ProxyFunction*> trial_proxies,
+                                                FlatArray<ProxyFunction*> test_proxies)
+  {
+    if (!dynamic_cast<const SpaceTimeFE<2>*> (&fel1) || !dynamic_cast<const SpaceTimeFE<2>*> (&fel2))
+      return false;
+    for (auto proxy : trial_proxies)
+      if (!IsSpaceTimeSeparable(*proxy)) return false;
+    for (auto proxy : test_proxies)
+      if (!IsSpaceTimeSeparable(*proxy)) return false;
+    return true;
+  }
+
+  // ir1, ir2 are the spatial rules of mir1, mir2, their time coordinate is
+  // overwritten. space_weights contain weights and measures of the spatial points.
+  static void CalcSpaceTimeFacetMatrixSumFactorized (const CoefficientFunction & cf,
+                                                     FlatArray<ProxyFunction*> trial_proxies,
+                                                     FlatArray<ProxyFunction*> test_proxies,
+                                                     const FiniteElement & fel1, const ElementTransformation & trafo1,
+                                                     IntegrationRule & ir1, const BaseMappedIntegrationRule & mir1,
+                                                     const FiniteElement & fel2,
+                                                     IntegrationRule & ir2, const BaseMappedIntegrationRule & mir2,
+                                                     FlatVector<> space_weights,
+                                                     const IntegrationRule & ir_time,
+                                                     FlatMatrix<double> elmat,
+                                                     LocalHeap & lh)
+  {
+    static Timer t ("SpaceTimeFacetMatrix - sum factorization");
+    RegionTimer reg(t);
+
+    auto & stfel1 = dynamic_cast<const SpaceTimeFE<2>&> (fel1);
+    auto & stfel2 = dynamic_cast<const SpaceTimeFE<2>&> (fel2);
+    const int nq = ir1.Size();
+
+    ProxyUserData ud;
+    const_cast<ElementTransformation&>(trafo1).userdata = &ud;
+
+    for (auto proxy1 : trial_proxies)
+      for (auto proxy2 : test_proxies)
+        {
+          HeapReset hr(lh);
+          const SpaceTimeFE<2> & st_trial = proxy1->IsOther() ? stfel2 : stfel1;
+          const SpaceTimeFE<2> & st_test = proxy2->IsOther() ? stfel2 : stfel1;
+          const ScalarFiniteElement<2> & s_trial = *st_trial.GetSpaceFE();
+          const ScalarFiniteElement<2> & s_test = *st_test.GetSpaceFE();
+          const int ns1 = s_trial.GetNDof(), nt1 = st_trial.GetTimeFE()->GetNDof();
+          const int ns2 = s_test.GetNDof(), nt2 = st_test.GetTimeFE()->GetNDof();
+          const int dim1 = proxy1->Dimension(), dim2 = proxy2->Dimension();
+
+          IntRange trial_range = proxy1->IsOther() ? IntRange(fel1.GetNDof(), elmat.Width()) : IntRange(0, fel1.GetNDof());
+          IntRange test_range = proxy2->IsOther() ? IntRange(fel1.GetNDof(), elmat.Height()) : IntRange(0, fel1.GetNDof());
+          auto loc_elmat = elmat.Rows(test_range).Cols(trial_range);
+
+          // spatial parts of trial and test functions, once for all time points
+          FlatMatrix<> bs1(nq*dim1, ns1, lh);
+          FlatMatrix<> bs2(nq*dim2, ns2, lh);
+          {
+            FlatMatrix<double,ColMajor> bmat1(dim1, ns1, lh);
+            FlatMatrix<double,ColMajor> bmat2(dim2, ns2, lh);
+            for (int j = 0; j < nq; j++)
+              {
+                proxy1->Evaluator()->CalcMatrix(s_trial, proxy1->IsOther() ? mir2[j] : mir1[j], bmat1, lh);
+                proxy2->Evaluator()->CalcMatrix(s_test, proxy2->IsOther() ? mir2[j] : mir1[j], bmat2, lh);
+                bs1.Rows(j*dim1, (j+1)*dim1) = bmat1;
+                bs2.Rows(j*dim2, (j+1)*dim2) = bmat2;
+              }
+          }
+
+          FlatMatrix<> val(nq, 1, lh);
+          FlatTensor<3> proxyvalues(lh, nq, dim2, dim1);
+          FlatMatrix<> bdbmat1(nq*dim2, ns1, lh);
+          FlatMatrix<> smat(ns2, ns1, lh);
+          FlatVector<> tshape1(nt1, lh), tshape2(nt2, lh);
+
+          for (const auto & ipt : ir_time)
+            {
+              for (int j = 0; j < nq; j++)
+                {
+                  ir1[j](2) = ipt(0);
+                  ir2[j](2) = ipt(0);
+                }
+
+              for (int k = 0; k < dim1; k++)
+                for (int l = 0; l < dim2; l++)
+                  {
+                    ud.trialfunction = proxy1;
+                    ud.trial_comp = k;
+                    ud.testfunction = proxy2;
+                    ud.test_comp = l;
+
+                    cf.Evaluate (mir1, val);
+                    proxyvalues(STAR,l,k) = val.Col(0);
+                  }
+
+              for (int j = 0; j < nq; j++)
+                {
+                  proxyvalues(j,STAR,STAR) *= space_weights(j) * ipt.Weight();
+                  bdbmat1.Rows(j*dim2, (j+1)*dim2) = proxyvalues(j,STAR,STAR) * bs1.Rows(j*dim1, (j+1)*dim1);
+                }
+              smat = Trans(bs2) * bdbmat1 | Lapack;
+
+              st_trial.GetTimeFE()->CalcShape(IntegrationPoint(st_trial.TimeOf(ir1[0])), tshape1);
+              st_test.GetTimeFE()->CalcShape(IntegrationPoint(st_test.TimeOf(ir1[0])), tshape2);
+              for (int a = 0; a < nt2; a++)
+                for (int b = 0; b < nt1; b++)
+                  loc_elmat.Rows(a*ns2, (a+1)*ns2).Cols(b*ns1, (b+1)*ns1) += (tshape2(a)*tshape1(b)) * smat;
+            }
+        }
+  }
+
   SymbolicFacetBilinearFormIntegrator2 ::
   SymbolicFacetBilinearFormIntegrator2 (shared_ptr<CoefficientFunction> acf,
                                         int aforce_intorder)
@@ -654,7 +781,22 @@ namespace ngfem
     IntegrationRule * ir_facet_vol1 = nullptr;
     IntegrationRule * ir_facet_vol2 = nullptr;
 
-    
+    if (time_order >= 0 && SpaceTimeSumFactorizationApplies(fel1, fel2, trial_proxies, test_proxies))
+    {
+      BaseMappedIntegrationRule & mir1 = trafo1(ir_facet_vol1_tmp, lh);
+      BaseMappedIntegrationRule & mir2 = trafo2(ir_facet_vol2_tmp, lh);
+      mir1.ComputeNormalsAndMeasure (eltype1, LocalFacetNr1);
+      mir2.ComputeNormalsAndMeasure (eltype2, LocalFacetNr2);
+      FlatVector<> space_weights(mir1.Size(), lh);
+      for (int i = 0; i < mir1.Size(); i++)
+        space_weights(i) = mir1[i].GetMeasure() * ir_facet_vol1_tmp[i].Weight();
+      CalcSpaceTimeFacetMatrixSumFactorized(*cf, trial_proxies, test_proxies,
+                                            fel1, trafo1, ir_facet_vol1_tmp, mir1,
+                                            fel2, ir_facet_vol2_tmp, mir2, space_weights,
+                                            SelectIntegrationRule(ET_SEGM, time_order), elmat, lh);
+      return;
+    }
+
     if (time_order >= 0)
     {
       FlatVector<> st_point(3,lh);
@@ -731,7 +873,8 @@ namespace ngfem
 
           for (int i = 0; i < mir1.Size(); i++)
             // proxyvalues(i,STAR,STAR) *= measure(i) * ir_facet[i].Weight();
-            proxyvalues(i,STAR,STAR) *= mir1[i].GetMeasure() * ir_facet[i].Weight();
+            // (space-time rules: facet weight times time weight)
+            proxyvalues(i,STAR,STAR) *= mir1[i].GetMeasure() * (*ir_facet_vol1)[i].Weight();
 
           IntRange trial_range  = proxy1->IsOther() ? IntRange(proxy1->Evaluator()->BlockDim()*fel1.GetNDof(), elmat.Width()) : IntRange(0, proxy1->Evaluator()->BlockDim()*fel1.GetNDof());
           IntRange test_range  = proxy2->IsOther() ? IntRange(proxy2->Evaluator()->BlockDim()*fel1.GetNDof(), elmat.Height()) : IntRange(0, proxy2->Evaluator()->BlockDim()*fel1.GetNDof());
@@ -865,7 +1008,20 @@ namespace ngfem
     IntegrationRule * ir1 = nullptr;
     IntegrationRule * ir2 = nullptr;
 
-    
+    if (time_order >= 0 && SpaceTimeSumFactorizationApplies(fel1, fel2, trial_proxies, test_proxies))
+    {
+      BaseMappedIntegrationRule & mir1 = trafo1(ir_patch1, lh);
+      BaseMappedIntegrationRule & mir2 = trafo2(ir_patch2, lh);
+      FlatVector<> space_weights(mir1.Size(), lh);
+      for (int i = 0; i < mir1.Size(); i++)
+        space_weights(i) = mir1[i].GetWeight();
+      CalcSpaceTimeFacetMatrixSumFactorized(*cf, trial_proxies, test_proxies,
+                                            fel1, trafo1, ir_patch1, mir1,
+                                            fel2, ir_patch2, mir2, space_weights,
+                                            SelectIntegrationRule(ET_SEGM, time_order), elmat, lh);
+      return;
+    }
+
     if (time_order >= 0)
     {
       FlatVector<> st_point(3,lh);
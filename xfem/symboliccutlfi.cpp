@@ -21,11 +21,12 @@ namespace ngfem
                                    int aforce_intorder,
                                    int asubdivlvl,
                                    SWAP_DIMENSIONS_POLICY apol,
-                                   VorB vb)
+                                   VorB vb,
+                                   bool highorder_lset)
     : SymbolicLinearFormIntegrator(acf,vb,VOL), cf_lset(acf_lset), dt(adt),
       force_intorder(aforce_intorder), subdivlvl(asubdivlvl), pol(apol)
   {
-    tie(cf_lset,gf_lset) = CF2GFForStraightCutRule(cf_lset,subdivlvl);
+    tie(cf_lset,gf_lset) = CF2GFForStraightCutRule(cf_lset,subdivlvl,highorder_lset);
   }
 
   void 
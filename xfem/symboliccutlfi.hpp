@@ -28,7 +28,8 @@ namespace ngfem
                                      int aforce_intorder = -1,
                                      int asubdivlvl = 0,
                                      SWAP_DIMENSIONS_POLICY apol = FIND_OPTIMAL,
-                                     VorB vb = VOL);
+                                     VorB vb = VOL,
+                                     bool highorder_lset = false);
 
     void SetTimeIntegrationOrder(int tiorder) { time_order = tiorder; }
     virtual VorB VB () const { return VOL; }
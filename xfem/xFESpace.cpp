@@ -255,6 +255,7 @@ namespace ngcomp
     RegionTimer reg (timer);
 
     FESpace::Update(lh);
+    dof_numbering_stamp++;
 
     int ne=ma->GetNE();
     int nedges=ma->GetNEdges();
@@ -298,6 +299,26 @@ namespace ngcomp
         sel2dofs = make_shared<Table<int>>(creator.MoveTable());
     }
 
+#ifdef PARALLEL
+    // dofs at process interfaces can belong to a cut element on another
+    // process only, the (exchanged) node marking of the cutinfo tells
+    if (MyMPI_GetNTasks() > 1)
+    {
+      Array<int> dnums;
+      for (NODE_TYPE nt : {NT_VERTEX,NT_EDGE,NT_FACE})
+      {
+        if (nt == NT_FACE && D == 2) continue;
+        for (int nnr : ma->Nodes(nt))
+          if (cutinfo->cut_neighboring_node[nt]->Test(nnr))
+          {
+            basefes->GetDofNrs(NodeId(nt,nnr), dnums);
+            for (int d : dnums)
+              if (d != -1) activedofs.Set(d);
+          }
+      }
+    }
+#endif
+
     int nbdofs = basefes->GetNDof();
     basedof2xdof.SetSize(nbdofs);
     basedof2xdof = -1;
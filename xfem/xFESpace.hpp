@@ -19,7 +19,7 @@ namespace ngcomp
 
   // Base class for extended finite elements with data for
   // mappings between degrees of freedoms and cut information
-  class XFESpace : public FESpace
+  class XFESpace : public FESpace, public CutDependentDofNumbering
   {
   protected:
     int ndof;
@@ -38,9 +38,12 @@ namespace ngcomp
     shared_ptr<CutInformation> cutinfo = NULL;
     bool private_cutinfo = true;  // <-- am I responsible for the cutinformation (or is it an external one)
     bool trace = false;   // xfespace is a trace fe space (special case for further optimization (CouplingDofTypes...))
+    size_t dof_numbering_stamp = 0;  // increased with every Update
   public:
     shared_ptr<FESpace> GetBaseFESpace() const { return basefes;};
 
+    virtual size_t GetDofNumberingStamp () const { return dof_numbering_stamp; }
+
     XFESpace (shared_ptr<MeshAccess> ama, shared_ptr<FESpace> abasefes,
               shared_ptr<CoefficientFunction> lset, const Flags & flags)
       : FESpace(ama, flags), basefes(abasefes)
@@ -175,6 +178,12 @@ namespace ngcomp
     int GetBaseDofOfXDof(int n) const { return xdof2basedof[n];}
     int GetXDofOfBaseDof(int n) const { return basedof2xdof[n];}
 
+    /// whole mapping arrays (e.g. for zero-copy access from python),
+    /// valid until the next Update
+    FlatArray<DOMAIN_TYPE> GetDomainOfDofs() const { return domofdof; }
+    FlatArray<int> GetBaseDofsOfXDofs() const { return xdof2basedof; }
+    FlatArray<int> GetXDofsOfBaseDofs() const { return basedof2xdof; }
+
     static void XToNegPos(shared_ptr<GridFunction> gf, shared_ptr<GridFunction> gf_neg_pos);
   };
 
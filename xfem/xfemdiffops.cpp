@@ -66,6 +66,85 @@ namespace ngfem
     }// xfe
   }// generate matrix
 
+  template <int D, DIFFOPX DOX>
+  void DiffOpX<D,DOX>::GenerateMatrixSIMDIR (const FiniteElement & bfel,
+                                             const SIMD_BaseMappedIntegrationRule & mir,
+                                             BareSliceMatrix<SIMD<double>> mat)
+  {
+    // XDummyFE has no dofs, nothing to do
+    const XFiniteElement * xfe = dynamic_cast<const XFiniteElement *> (&bfel);
+    if (!xfe) return;
+
+    if (DOX < DIFFOPX::EXTEND_GRAD)
+      xfe->CalcShape<D>(mir.IR(), DT, mat);
+    else
+      xfe->CalcMappedDShape<D>(mir, DT, mat);
+  }
+
+  template <int D, DIFFOPX DOX>
+  void DiffOpX<D,DOX>::ApplySIMDIR (const FiniteElement & bfel, const SIMD_BaseMappedIntegrationRule & mir,
+                                    BareSliceVector<double> x, BareSliceMatrix<SIMD<double>> y)
+  {
+    const XFiniteElement * xfe = dynamic_cast<const XFiniteElement *> (&bfel);
+    if (!xfe)
+    {
+      for (int k = 0; k < DIM_DMAT; k++)
+        for (size_t j = 0; j < mir.Size(); j++)
+          y(k,j) = SIMD<double>(0.0);
+      return;
+    }
+    const ScalarFiniteElement<D> & scafe =
+      dynamic_cast<const ScalarFiniteElement<D> & > (xfe->GetBaseFE());
+    const int ndof = scafe.GetNDof();
+
+    // restriction to a domain: apply the mask on the coefficients
+    STACK_ARRAY(double, mem, ndof);
+    FlatVector<> xmasked(ndof, &mem[0]);
+    if (DT == IF)
+      for (int i = 0; i < ndof; i++)
+        xmasked(i) = x(i);
+    else
+    {
+      FlatVector<> mask = xfe->GetDomainMask(DT);
+      for (int i = 0; i < ndof; i++)
+        xmasked(i) = mask(i) * x(i);
+    }
+
+    if (DOX < DIFFOPX::EXTEND_GRAD)
+      scafe.Evaluate(mir.IR(), xmasked, y.Row(0));
+    else
+      scafe.EvaluateGrad(mir, xmasked, y);
+  }
+
+  template <int D, DIFFOPX DOX>
+  void DiffOpX<D,DOX>::AddTransSIMDIR (const FiniteElement & bfel, const SIMD_BaseMappedIntegrationRule & mir,
+                                       BareSliceMatrix<SIMD<double>> y, BareSliceVector<double> x)
+  {
+    const XFiniteElement * xfe = dynamic_cast<const XFiniteElement *> (&bfel);
+    if (!xfe) return;
+    const ScalarFiniteElement<D> & scafe =
+      dynamic_cast<const ScalarFiniteElement<D> & > (xfe->GetBaseFE());
+    const int ndof = scafe.GetNDof();
+
+    STACK_ARRAY(double, mem, ndof);
+    FlatVector<> xlocal(ndof, &mem[0]);
+    xlocal = 0.0;
+    if (DOX < DIFFOPX::EXTEND_GRAD)
+      scafe.AddTrans(mir.IR(), y.Row(0), xlocal);
+    else
+      scafe.AddGradTrans(mir, y, xlocal);
+
+    if (DT == IF)
+      for (int i = 0; i < ndof; i++)
+        x(i) += xlocal(i);
+    else
+    {
+      FlatVector<> mask = xfe->GetDomainMask(DT);
+      for (int i = 0; i < ndof; i++)
+        x(i) += mask(i) * xlocal(i);
+    }
+  }
+
   template class T_DifferentialOperator<DiffOpX<2,DIFFOPX::EXTEND>>;
   template class T_DifferentialOperator<DiffOpX<2,DIFFOPX::RNEG>>;
   template class T_DifferentialOperator<DiffOpX<2,DIFFOPX::RPOS>>;
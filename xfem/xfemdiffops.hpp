@@ -23,9 +23,23 @@ namespace ngfem
     enum { DIM_DMAT = DOX < 3 ? 1 : D };     // D-matrix
     enum { DIFFORDER = DOX < 3 ? 0 : 1 };    // minimal differential order (to determine integration order)
 
+    /// domain the operator is restricted to (IF: no restriction)
+    static constexpr DOMAIN_TYPE DT = (DOX == RNEG || DOX == RNEG_GRAD) ? NEG
+      : ((DOX == RPOS || DOX == RPOS_GRAD) ? POS : IF);
+
     template <typename FEL, typename MIP, typename MAT>
     static void GenerateMatrix (const FEL & bfel, const MIP & sip,
                                 MAT & mat, LocalHeap & lh);
+
+    static void GenerateMatrixSIMDIR (const FiniteElement & bfel,
+                                      const SIMD_BaseMappedIntegrationRule & mir,
+                                      BareSliceMatrix<SIMD<double>> mat);
+
+    static void ApplySIMDIR (const FiniteElement & bfel, const SIMD_BaseMappedIntegrationRule & mir,
+                             BareSliceVector<double> x, BareSliceMatrix<SIMD<double>> y);
+
+    static void AddTransSIMDIR (const FiniteElement & bfel, const SIMD_BaseMappedIntegrationRule & mir,
+                                BareSliceMatrix<SIMD<double>> y, BareSliceVector<double> x);
   };
 
 #ifndef FILE_XFEMDIFFOPS_CPP
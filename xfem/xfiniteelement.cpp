@@ -11,12 +11,18 @@ namespace ngfem
   XFiniteElement::XFiniteElement(const FiniteElement & a_base, const Array<DOMAIN_TYPE>& a_localsigns,
                                  Allocator & lh)
     : base(a_base),
-    localsigns(a_localsigns.Size(),lh)
+    localsigns(a_localsigns.Size(),lh),
+    mask_neg(a_localsigns.Size(),lh),
+    mask_pos(a_localsigns.Size(),lh)
   {
     ndof = base.GetNDof();
     order = base.Order();
     for (int l = 0; l < localsigns.Size(); ++l)
+    {
       localsigns[l] = a_localsigns[l];
+      mask_neg(l) = localsigns[l] == NEG ? 1.0 : 0.0;
+      mask_pos(l) = localsigns[l] == POS ? 1.0 : 0.0;
+    }
   };
 
 
@@ -29,6 +35,40 @@ namespace ngfem
     return localsigns;
   };
 
+  template <int D>
+  void XFiniteElement::CalcShape (const SIMD_IntegrationRule & ir, DOMAIN_TYPE dt,
+                                  BareSliceMatrix<SIMD<double>> shapes) const
+  {
+    const ScalarFiniteElement<D> & scafe = dynamic_cast<const ScalarFiniteElement<D> & > (base);
+    scafe.CalcShape(ir, shapes);
+    if (dt == IF) return;
+    FlatVector<> mask = GetDomainMask(dt);
+    for (int i = 0; i < ndof; i++)
+      if (mask(i) == 0.0)
+        for (size_t j = 0; j < ir.Size(); j++)
+          shapes(i,j) = SIMD<double>(0.0);
+  }
+
+  template <int D>
+  void XFiniteElement::CalcMappedDShape (const SIMD_BaseMappedIntegrationRule & mir, DOMAIN_TYPE dt,
+                                         BareSliceMatrix<SIMD<double>> dshapes) const
+  {
+    const ScalarFiniteElement<D> & scafe = dynamic_cast<const ScalarFiniteElement<D> & > (base);
+    scafe.CalcMappedDShape(mir, dshapes);
+    if (dt == IF) return;
+    FlatVector<> mask = GetDomainMask(dt);
+    for (int i = 0; i < ndof; i++)
+      if (mask(i) == 0.0)
+        for (int k = 0; k < D; k++)
+          for (size_t j = 0; j < mir.Size(); j++)
+            dshapes(i*D+k,j) = SIMD<double>(0.0);
+  }
+
+  template void XFiniteElement::CalcShape<2> (const SIMD_IntegrationRule &, DOMAIN_TYPE, BareSliceMatrix<SIMD<double>>) const;
+  template void XFiniteElement::CalcShape<3> (const SIMD_IntegrationRule &, DOMAIN_TYPE, BareSliceMatrix<SIMD<double>>) const;
+  template void XFiniteElement::CalcMappedDShape<2> (const SIMD_BaseMappedIntegrationRule &, DOMAIN_TYPE, BareSliceMatrix<SIMD<double>>) const;
+  template void XFiniteElement::CalcMappedDShape<3> (const SIMD_BaseMappedIntegrationRule &, DOMAIN_TYPE, BareSliceMatrix<SIMD<double>>) const;
+
 
 
   void SFiniteElement::CalcShape (const IntegrationPoint & ip,
@@ -36,6 +36,9 @@ namespace ngfem
   protected:
     const FiniteElement & base;
     const FlatArray<DOMAIN_TYPE> localsigns;
+    /// 1.0 for dofs of the domain, 0.0 otherwise
+    FlatVector<> mask_neg;
+    FlatVector<> mask_pos;
   public:
     XFiniteElement(const FiniteElement & a_base,
                    const Array<DOMAIN_TYPE>& a_localsigns,
@@ -48,6 +51,20 @@ namespace ngfem
 
     const FlatArray<DOMAIN_TYPE>& GetSignsOfDof() const;
 
+    /// mask of dofs of domain dt (1.0 for dofs of dt, 0.0 otherwise)
+    FlatVector<> GetDomainMask(DOMAIN_TYPE dt) const { return dt == NEG ? mask_neg : mask_pos; }
+
+    /// shapes of the (scalar) base element on a whole SIMD rule, shapes of
+    /// dofs not belonging to dt are set to zero (no restriction for dt == IF)
+    template <int D>
+    void CalcShape (const SIMD_IntegrationRule & ir, DOMAIN_TYPE dt,
+                    BareSliceMatrix<SIMD<double>> shapes) const;
+
+    /// mapped derivatives (ndof*D rows) of the base element, masked as in CalcShape
+    template <int D>
+    void CalcMappedDShape (const SIMD_BaseMappedIntegrationRule & mir, DOMAIN_TYPE dt,
+                           BareSliceMatrix<SIMD<double>> dshapes) const;
+
     virtual ELEMENT_TYPE ElementType() const override { return base.ElementType(); }
   };
 